@@ -0,0 +1,457 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../permutation_checksum.h"
+#include "../permutation_compress.h"
+#include "../permutation_indirect.h"
+#include "../permutation_lehmer.h"
+#include "../permutation_map.h"
+#include "../permutation_matrix.h"
+#include "../permutation_metrics.h"
+#include "../permutation_output.h"
+#include "../permutation_prefix.h"
+#include "../permutation_registry.h"
+#include "../permutation_storage.h"
+
+using namespace permutation_algorithms;
+
+namespace
+{
+    // Element storage shared by all benchmarks; perm_type refers into it.
+    const std::vector<std::string> bench_strings{"0", "1", "2", "3", "4", "5", "6", "7", "8", "9"};
+
+    void count_each_perm(const perm_iterator_type, const perm_iterator_type, const std::any &user_data)
+    {
+        ++*std::any_cast<int64_t *>(user_data);
+    }
+
+    void bench_engine(benchmark::State &state, const registry::engine *e)
+    {
+        const perm_type elems(std::cbegin(bench_strings), std::next(std::cbegin(bench_strings), state.range(0)));
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            e->perm_all(std::cbegin(elems), std::cend(elems), count_each_perm, &count);
+        }
+        benchmark::DoNotOptimize(count);
+        state.SetItemsProcessed(count);
+    }
+
+    void print_each_perm(const perm_iterator_type first, const perm_iterator_type last, const std::any &user_data)
+    {
+        std::any_cast<output_buffer *>(user_data)->append(first, last);
+    }
+
+    // Printing 9! permutations to a sink that discards its input, directly or through
+    // a parallel compressor with state.range(0) threads.
+    void bench_output(benchmark::State &state, const compress::codec c)
+    {
+        const perm_type elems(std::cbegin(bench_strings), std::next(std::cbegin(bench_strings), 9));
+        int64_t raw_bytes = 0, compressed_bytes = 0;
+        for (auto _ : state)
+        {
+            std::optional<compress::parallel_compressor> pc;
+            block_sink_type sink = [&](const std::string_view block) { compressed_bytes += std::size(block); };
+            if (c != compress::codec::none)
+            {
+                pc.emplace(sink, c, 1, static_cast<unsigned int>(state.range(0)));
+                sink = pc->sink();
+            }
+            output_buffer out([&](const std::string_view block) { raw_bytes += std::size(block); sink(block); });
+            permutation4::perm_all(std::cbegin(elems), std::cend(elems), print_each_perm, &out);
+            out.flush();
+            if (pc) pc->finish();
+        }
+        state.SetBytesProcessed(raw_bytes);
+        state.counters["ratio"] = static_cast<double>(raw_bytes) / compressed_bytes;
+    }
+
+    // Advancing a permutation of state.range(0) elements by a 128-bit step.
+    void bench_advance(benchmark::State &state)
+    {
+        std::vector<int> p(static_cast<std::size_t>(state.range(0)));
+        std::iota(std::begin(p), std::end(p), 0);
+        const lehmer::rank128_type step = ~static_cast<lehmer::rank128_type>(0) / 3;
+        for (auto _ : state)
+        {
+            lehmer::advance(std::begin(p), std::end(p), step);
+            benchmark::DoNotOptimize(p.data());
+        }
+        state.SetComplexityN(state.range(0));
+    }
+
+    // Converting between a rank of about n log n bits and its Lehmer code.
+    void bench_rank_code(benchmark::State &state)
+    {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        const auto r = lehmer::big_rank_type(lehmer::factorial(n) / 3);
+        for (auto _ : state)
+        {
+            const auto code = lehmer::rank_to_code(r, n);
+            benchmark::DoNotOptimize(lehmer::code_to_rank(code));
+        }
+        state.SetComplexityN(state.range(0));
+    }
+
+    // Scoring every permutation of state.range(0) items against a reference.
+    void bench_kendall_tau_each(benchmark::State &state)
+    {
+        metrics::index_perm_type reference(static_cast<std::size_t>(state.range(0)));
+        std::iota(std::rbegin(reference), std::rend(reference), 0);
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            std::uint64_t sum = 0;
+            metrics::kendall_tau_each(reference, [&](const metrics::index_perm_type &, const std::uint64_t d) { sum += d; ++count; });
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // A per-position cost, standing in for an expensive evaluation step.
+    double position_cost(const double before, const elem_type e, const std::size_t i)
+    {
+        return before + static_cast<double>(e[0] - '0') * static_cast<double>(i + 1) / (before + 1.0);
+    }
+
+    // Evaluating position_cost over every permutation of 9 elements in lexicographic
+    // order, by folding over each permutation in full or by prefix_eval.
+    void bench_prefix(benchmark::State &state, const bool memoized)
+    {
+        const perm_type elems(std::cbegin(bench_strings), std::next(std::cbegin(bench_strings), 9));
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            double sum = 0;
+            if (memoized)
+            {
+                prefix_eval::perm_all_lex(std::cbegin(elems), std::cend(elems), 0.0, position_cost,
+                    [&](auto, auto, const double cost) { sum += cost; ++count; });
+            }
+            else
+            {
+                permutation_std::perm_all(std::cbegin(elems), std::cend(elems),
+                    [&](const perm_iterator_type first, const perm_iterator_type last, const std::any &) {
+                        double cost = 0;
+                        for (auto it = first; it != last; ++it) cost = position_cost(cost, *it, static_cast<std::size_t>(it - first));
+                        sum += cost;
+                        ++count;
+                    },
+                    {});
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // Heap's algorithm over 9 objects of Size bytes, swapping the objects themselves
+    // or their handles, reading the first byte of each permutation's first object.
+    template <std::size_t Size>
+    void bench_heavy(benchmark::State &state, const bool by_handle)
+    {
+        using heavy = std::array<char, Size>;
+        std::vector<heavy> objects(9);
+        for (std::size_t i = 0; i < std::size(objects); ++i) objects[i].fill(static_cast<char>(i));
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            long sum = 0;
+            if (by_handle)
+            {
+                indirect::heap(std::size(objects), [&](const indirect::handles_type &h) { sum += objects[h[0]][0]; ++count; });
+            }
+            else
+            {
+                auto a = objects;
+                std::vector<std::size_t> c(std::size(a), 0);
+                sum += a[0][0];
+                ++count;
+                for (std::size_t i = 1; i < std::size(a); )
+                {
+                    if (c[i] < i)
+                    {
+                        std::swap(a[(i & 1) == 0 ? 0 : c[i]], a[i]);
+                        sum += a[0][0];
+                        ++count;
+                        ++c[i];
+                        i = 1;
+                    }
+                    else
+                    {
+                        c[i] = 0;
+                        ++i;
+                    }
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // Heap's algorithm over 10 handles, computing each swap from the counters or, with
+    // state.range(0) > 0, replaying the swap table of that many bottom levels.
+    void bench_heap_steps(benchmark::State &state)
+    {
+        const auto levels = static_cast<unsigned int>(state.range(0));
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            long sum = 0;
+            auto visit = [&](const auto f, const auto) { sum += *f; ++count; };
+            if (levels == 0)
+            {
+                indirect::heap(10, [&](const indirect::handles_type &h) { visit(std::cbegin(h), std::cend(h)); });
+            }
+            else
+            {
+                indirect::handles_type h(10);
+                std::iota(std::begin(h), std::end(h), 0);
+                permutation5::perm_each(std::begin(h), std::end(h), visit, levels);
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // A hardware event of this thread counted with perf_event_open, when the kernel and
+    // its perf_event_paranoid setting allow it.
+    class perf_counter
+    {
+    public:
+        perf_counter(const std::uint32_t type, const std::uint64_t config)
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        perf_counter(const perf_counter &) = delete;
+        perf_counter &operator=(const perf_counter &) = delete;
+        ~perf_counter() { if (fd_ >= 0) ::close(fd_); }
+
+        bool available() const { return fd_ >= 0; }
+        void start()
+        {
+            if (fd_ < 0) return;
+            ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        std::uint64_t stop()
+        {
+            std::uint64_t value = 0;
+            if (fd_ < 0) return value;
+            ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (::read(fd_, &value, sizeof(value)) != sizeof(value)) value = 0;
+            return value;
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+    constexpr std::uint64_t dtlb_event(const std::uint64_t op)
+    {
+        return PERF_COUNT_HW_CACHE_DTLB | op << 8 | std::uint64_t{PERF_COUNT_HW_CACHE_RESULT_MISS} << 16;
+    }
+
+    // Materializing the state.range(0)! permutations of plain changes into vectors
+    // (policy empty) or flat storage with policy, then reading every element, with the
+    // dTLB misses of each phase per iteration where perf counters are available.
+    void bench_storage(benchmark::State &state, const std::optional<storage::page_policy> policy)
+    {
+        const perm_type elems(std::cbegin(bench_strings), std::next(std::cbegin(bench_strings), state.range(0)));
+        perf_counter loads(PERF_TYPE_HW_CACHE, dtlb_event(PERF_COUNT_HW_CACHE_OP_READ));
+        perf_counter stores(PERF_TYPE_HW_CACHE, dtlb_event(PERF_COUNT_HW_CACHE_OP_WRITE));
+        double fill_misses = 0, scan_misses = 0;
+        int64_t count = 0;
+        std::string label;
+        for (auto _ : state)
+        {
+            loads.start();
+            stores.start();
+            if (policy)
+            {
+                const auto flat = storage::materialize(permutation2::perm_all<perm_iterator_type>, std::cbegin(elems), std::cend(elems), *policy);
+                fill_misses += double(loads.stop() + stores.stop());
+                loads.start();
+                std::size_t sum = 0;
+                for (std::size_t i = 0; i < flat.size(); ++i) for (const auto e : flat[i]) sum += std::size(e);
+                benchmark::DoNotOptimize(sum);
+                scan_misses += double(loads.stop());
+                count += static_cast<int64_t>(flat.size());
+                label = storage::to_string(flat.policy());
+            }
+            else
+            {
+                const auto rows = perm_all_container<std::vector<perm_type>>(permutation2::perm_all<perm_iterator_type>, std::cbegin(elems), std::cend(elems));
+                fill_misses += double(loads.stop() + stores.stop());
+                loads.start();
+                std::size_t sum = 0;
+                for (const auto &row : rows) for (const auto e : row) sum += std::size(e);
+                benchmark::DoNotOptimize(sum);
+                scan_misses += double(loads.stop());
+                count += static_cast<int64_t>(std::size(rows));
+            }
+        }
+        if (loads.available())
+        {
+            state.counters["fill_dtlb_misses"] = benchmark::Counter(fill_misses, benchmark::Counter::kAvgIterations);
+            state.counters["scan_dtlb_misses"] = benchmark::Counter(scan_misses, benchmark::Counter::kAvgIterations);
+        }
+        else
+        {
+            label += label.empty() ? "no perf counters" : ", no perf counters";
+        }
+        state.SetLabel(label);
+        state.SetItemsProcessed(count);
+    }
+
+    struct perm_hasher
+    {
+        std::size_t operator()(const perm_type &p) const { return checksum::perm_hash(std::cbegin(p), std::cend(p)); }
+    };
+
+    // A hash map with perm_map's constructor.
+    struct perm_hash_map : std::unordered_map<perm_type, int, perm_hasher>
+    {
+        perm_hash_map(const perm_iterator_type, const perm_iterator_type) {}
+    };
+
+    // Counting visits of each of the 9! permutations of Heap's algorithm, keyed by the
+    // permutation in a hash map or by its rank in a perm_map.
+    template <typename TMap>
+    void bench_perm_map(benchmark::State &state)
+    {
+        perm_type elems(std::cbegin(bench_strings), std::next(std::cbegin(bench_strings), 9));
+        TMap visits(std::cbegin(elems), std::cend(elems));
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            permutation5::perm_each(std::begin(elems), std::end(elems), [&](const auto f, const auto l) {
+                if constexpr (std::is_same_v<TMap, perm_index::perm_map<int>>) ++visits.at(f, l);
+                else ++visits[perm_type(f, l)];
+                ++count;
+            });
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // As bench_perm_map with a perm_map, generating index permutations, which are ranked
+    // without looking the elements up.
+    void bench_perm_map_indices(benchmark::State &state)
+    {
+        const perm_type elems(std::cbegin(bench_strings), std::next(std::cbegin(bench_strings), 9));
+        perm_index::perm_map<int> visits(std::cbegin(elems), std::cend(elems));
+        std::vector<std::uint8_t> indices(9);
+        std::iota(std::begin(indices), std::end(indices), 0);
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            permutation5::perm_each(std::begin(indices), std::end(indices), [&](const auto, const auto) {
+                ++visits[visits.index().rank(indices)];
+                ++count;
+            });
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // The length of the path 0, 1, ..., n-1 through every reordering of an n by n distance
+    // matrix: gathering each view, or updating one view by adjacent row and column swaps.
+    void bench_matrix(benchmark::State &state, const bool incremental)
+    {
+        const auto n = static_cast<std::size_t>(state.range(0));
+        std::vector<double> m(n * n);
+        std::iota(std::begin(m), std::end(m), 1.0);
+        const auto path = [n](const double *view) {
+            double r = 0;
+            for (std::size_t i = 0; i + 1 < n; ++i) r += view[i * n + i + 1];
+            return r;
+        };
+        int64_t count = 0;
+        for (auto _ : state)
+        {
+            double shortest = std::numeric_limits<double>::max();
+            if (incremental)
+            {
+                matrix::for_each_permuted<double>(m, n, [&](const matrix::permuted_matrix<double> &view) {
+                    shortest = std::min(shortest, path(std::data(view.data())));
+                });
+            }
+            else
+            {
+                std::vector<matrix::index_type> p(n);
+                std::iota(std::begin(p), std::end(p), matrix::index_type{0});
+                std::vector<double> view(n * n);
+                const auto visit = [&] {
+                    matrix::gather<double>(m, n, p, view);
+                    shortest = std::min(shortest, path(std::data(view)));
+                };
+                visit();
+                permutation2::perm_adjacent_swaps(static_cast<int>(n), [&](const int i) {
+                    std::swap(p[i], p[i + 1]);
+                    visit();
+                });
+            }
+            benchmark::DoNotOptimize(shortest);
+            count += static_cast<int64_t>(permutation_rank::factorial(static_cast<unsigned int>(n)));
+        }
+        state.SetItemsProcessed(count);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    for (const auto &e : registry::engines())
+    {
+        benchmark::RegisterBenchmark(("perm_all/" + e.name).c_str(), bench_engine, &e)->DenseRange(6, 9);
+    }
+    benchmark::RegisterBenchmark("output/none", bench_output, compress::codec::none)->Arg(1)->UseRealTime();
+    for (const auto c : {compress::codec::gzip, compress::codec::zstd, compress::codec::lz4})
+    {
+        if (!compress::available(c)) continue;
+        benchmark::RegisterBenchmark(("output/" + std::string(compress::to_string(c))).c_str(), bench_output, c)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+    }
+    benchmark::RegisterBenchmark("lehmer/advance", bench_advance)->RangeMultiplier(4)->Range(64, 4096)->Complexity(benchmark::oNLogN);
+    benchmark::RegisterBenchmark("lehmer/rank_code", bench_rank_code)->RangeMultiplier(4)->Range(64, 4096)->Complexity();
+    benchmark::RegisterBenchmark("metrics/kendall_tau_each", bench_kendall_tau_each)->DenseRange(8, 10);
+    benchmark::RegisterBenchmark("prefix/full", bench_prefix, false);
+    benchmark::RegisterBenchmark("prefix/memoized", bench_prefix, true);
+    benchmark::RegisterBenchmark("heavy/direct/8", bench_heavy<8>, false);
+    benchmark::RegisterBenchmark("heavy/direct/64", bench_heavy<64>, false);
+    benchmark::RegisterBenchmark("heavy/direct/256", bench_heavy<256>, false);
+    benchmark::RegisterBenchmark("heavy/handle/8", bench_heavy<8>, true);
+    benchmark::RegisterBenchmark("heavy/handle/64", bench_heavy<64>, true);
+    benchmark::RegisterBenchmark("heavy/handle/256", bench_heavy<256>, true);
+    benchmark::RegisterBenchmark("heap_steps/computed", bench_heap_steps)->Arg(0);
+    benchmark::RegisterBenchmark("heap_steps/table", bench_heap_steps)->DenseRange(4, 8);
+    benchmark::RegisterBenchmark("storage/vector", bench_storage, std::nullopt)->Arg(9)->Arg(10)->Unit(benchmark::kMillisecond);
+    for (const auto policy : {storage::page_policy::normal, storage::page_policy::transparent, storage::page_policy::hugetlb})
+    {
+        benchmark::RegisterBenchmark(("storage/" + std::string(storage::to_string(policy))).c_str(), bench_storage, policy)->Arg(9)->Arg(10)->Unit(benchmark::kMillisecond);
+    }
+    benchmark::RegisterBenchmark("perm_map/unordered_map", bench_perm_map<perm_hash_map>);
+    benchmark::RegisterBenchmark("perm_map/dense", bench_perm_map<perm_index::perm_map<int>>);
+    benchmark::RegisterBenchmark("perm_map/dense_indices", bench_perm_map_indices);
+    benchmark::RegisterBenchmark("matrix/gather", bench_matrix, false)->DenseRange(8, 11)->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("matrix/incremental", bench_matrix, true)->DenseRange(8, 11)->Unit(benchmark::kMillisecond);
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
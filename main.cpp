@@ -1,12 +1,32 @@
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <csignal>
 #include "boost/program_options.hpp"
 #include "boost/program_options/options_description.hpp"
 #include "boost/program_options/parsers.hpp"
 #include "boost/program_options/positional_options.hpp"
 #include "boost/program_options/variables_map.hpp"
 #include "permutation.h"
+#include "permutation_autotune.h"
+#include "permutation_checksum.h"
+#include "permutation_compress.h"
+#include "permutation_job.h"
+#include "permutation_numa.h"
+#include "permutation_output.h"
+#include "permutation_parallel.h"
+#include "permutation_pipeline.h"
+#include "permutation_registry.h"
+#include "permutation_server.h"
+#include "permutation_shard.h"
+#include "permutation_table.h"
 
 using namespace permutation_algorithms;
 using namespace std::literals::string_literals;
@@ -14,10 +34,49 @@ using namespace std::literals::string_literals;
 namespace
 {
     bool opt_count = false;
+    bool opt_checksum = false;
+    bool opt_ordered = false;
+    bool opt_pipeline = false;
+    bool opt_numa = false;
+    pipeline::options opt_pipeline_options;
     std::string opt_algorithm;
+    std::string opt_order;
+    std::optional<unsigned int> opt_threads;
+    std::optional<std::size_t> opt_batch_size;
+    std::string opt_profile;
+    std::string opt_input;
+    std::string opt_serve;
+    compress::codec opt_compress = compress::codec::none;
+    int opt_compress_level = 0;
+    unsigned int opt_compress_threads = 0;
+    std::string opt_compress_index;
+    std::string opt_output;
+    std::optional<shard::shard_spec> opt_shard;
+    std::string opt_manifest;
+    bool opt_table = false;
+    bool opt_table_shm = false;
+    bool opt_table_verify = false;
+    std::string opt_table_cache;
     std::vector<std::string> opt_elements;
 }
 
+void list_engines()
+{
+    using namespace registry;
+    for (const auto &e : engines())
+    {
+        const auto &p = e.properties;
+        std::cout << e.name << "\t" << e.description << "\n"
+            << "\torder=" << to_string(p.order)
+            << " transposition=" << p.transposition
+            << " adjacent=" << p.adjacent
+            << " range=" << p.supports_range
+            << " parallel=" << p.supports_parallel
+            << "\n";
+    }
+    std::cout << "auto\tThe fastest algorithm for the requested order.\n";
+}
+
 void process_cmdline(int argc, char *argv[])
 {
     using namespace boost::program_options;
@@ -25,8 +84,37 @@ void process_cmdline(int argc, char *argv[])
     options_description opts("options");
     opts.add_options()
         ("count,c", "Print the number of permutations only.")
-        ("algorithm,a", value<std::string>()->default_value("std"s), "Permutation algorithm. Possible values are 1, 2, 3, 4 or std.")
-        ("elements", value<std::vector<std::string>>()->required(), "Elements to permute.")
+        ("checksum", "Print the number of permutations and a checksum of them that does not depend on their order, "
+            "so that algorithms, thread counts and shards can be compared.")
+        ("algorithm,a", value<std::string>()->default_value("std"s), "Permutation algorithm. See --list for possible values, or auto.")
+        ("order,o", value<std::string>()->default_value("any"s), "Output order required by --algorithm auto: any, lexicographic, insertion, plain_changes or heap.")
+        ("list,l", "List the algorithms and exit.")
+        ("threads,t", value<unsigned int>(), "Number of threads (0 for all cores). Output order is not kept with more than one unless --ordered.")
+        ("ordered", "With --threads, print in exactly the order of one thread.")
+        ("numa", "With --threads, pin the threads to CPUs spread over the NUMA nodes, keep each thread's buffers on its node, and report the throughput of each node to stderr.")
+        ("pipeline", "Generate on one thread and format the output on --consumers other threads, passing batches through a lock-free queue.")
+        ("consumers", value<unsigned int>(&opt_pipeline_options.consumers)->default_value(opt_pipeline_options.consumers), "Number of consumer threads of --pipeline.")
+        ("queue-depth", value<std::size_t>(&opt_pipeline_options.depth)->default_value(opt_pipeline_options.depth), "Batches of permutations --pipeline queues before the generator waits.")
+        ("batch-size", value<std::size_t>(), "Bytes of output to buffer before writing.")
+        ("profile", value<std::string>()->default_value(autotune::default_profile_path().string()), "Profile written by the autotune command, consulted by --algorithm auto and by auto jobs of --serve.")
+        ("compress", value<std::string>()->default_value("none"s), "Compress printed output: none, gzip, zstd or lz4. Each block of --batch-size bytes becomes an independent frame.")
+        ("compress-level", value<int>(&opt_compress_level)->default_value(0), "Compression level; 0 for the codec's default.")
+        ("compress-threads", value<unsigned int>(&opt_compress_threads)->default_value(0), "Number of compression threads (0 for all cores).")
+        ("compress-index", value<std::string>(), "Write the uncompressed and compressed offset of each frame to this file.")
+        ("input,i", value<std::string>(), "Read elements to permute from this file (- for stdin), one problem per line, instead of the command line. "
+            "Each problem's permutations are followed by an empty line, or with --count, its number of permutations is printed on a line.")
+        ("output,O", value<std::string>(), "Write printed output to this file instead of stdout.")
+        ("shard", value<std::string>(), "Enumerate only shard i/N (0 <= i < N) of the rank space of --algorithm, which must support ranges, "
+            "and write a --manifest. Run every shard, in any processes or hosts, then check them with the verify-shards command.")
+        ("manifest", value<std::string>(), "With --shard, write the ranks covered, the number of permutations and the checksum of the output to this file.")
+        ("table", "Substitute the elements into a table of all index permutations in the order of --algorithm, "
+            "mapped from --table-cache and generated there on first use, instead of running the algorithm. Up to 12 elements.")
+        ("table-cache", value<std::string>(&opt_table_cache)->default_value(table::default_cache_dir().string()), "Directory of the tables of --table.")
+        ("table-verify", "With --table, check the checksum of the cached table before use, regenerating it if corrupt. This reads the whole table.")
+        ("table-shm", "With --table, map the table from POSIX shared memory instead of --table-cache, publishing it there unless another process has, "
+            "so that concurrent processes share one copy. Remove it with the unpublish-table command.")
+        ("serve", value<std::string>(), "Serve jobs on this Unix domain socket until interrupted, with --threads connections at a time. See permutation_server.h for the protocol.")
+        ("elements", value<std::vector<std::string>>(), "Elements to permute.")
         ("help,H", "Print this help.")
     ;
     positional_options_description args;
@@ -40,70 +128,491 @@ void process_cmdline(int argc, char *argv[])
         std::cout << opts << std::endl;
         throw opts;
     }
+    if (vm.count("list"))
+    {
+        list_engines();
+        throw opts;
+    }
+    if (vm.count("serve"))
+    {
+        opt_serve = vm["serve"].as<std::string>();
+    }
+    else if (vm.count("input"))
+    {
+        if (vm.count("elements")) throw std::invalid_argument("elements are given both by --input and on the command line");
+        opt_input = vm["input"].as<std::string>();
+    }
+    else if (!vm.count("elements"))
+    {
+        throw std::invalid_argument("no elements to permute");
+    }
 
-    opt_count = vm.count("count");
+    opt_checksum = vm.count("checksum");
+    opt_count = vm.count("count") || opt_checksum;
+    if (opt_checksum && (!opt_input.empty() || !opt_serve.empty())) throw std::invalid_argument("--checksum is not supported with --input or --serve");
+    opt_ordered = vm.count("ordered");
+    opt_pipeline = vm.count("pipeline");
+    opt_numa = vm.count("numa");
+    if (opt_numa && opt_ordered) throw std::invalid_argument("--ordered is not supported with --numa");
+    opt_table = vm.count("table");
+    opt_table_shm = vm.count("table-shm");
+    opt_table_verify = vm.count("table-verify");
+    if (opt_table_shm && !opt_table) throw std::invalid_argument("--table-shm needs --table");
+    if (opt_table_verify && (!opt_table || opt_table_shm)) throw std::invalid_argument("--table-verify needs --table without --table-shm");
+    if (opt_table && (!opt_input.empty() || !opt_serve.empty())) throw std::invalid_argument("--table is not supported with --input or --serve");
+    if (opt_pipeline_options.consumers == 0 || opt_pipeline_options.depth == 0) throw std::invalid_argument("consumers and queue depth must be positive");
     opt_algorithm = vm["algorithm"].as<std::string>();
-    opt_elements = vm["elements"].as<std::vector<std::string>>();
+    opt_order = vm["order"].as<std::string>();
+    if (vm.count("threads")) opt_threads = vm["threads"].as<unsigned int>();
+    if (vm.count("batch-size")) opt_batch_size = vm["batch-size"].as<std::size_t>();
+    if (opt_batch_size == 0u) throw std::invalid_argument("batch size must be positive");
+    opt_profile = vm["profile"].as<std::string>();
+    opt_compress = compress::parse_codec(vm["compress"].as<std::string>());
+    if (vm.count("compress-index")) opt_compress_index = vm["compress-index"].as<std::string>();
+    if (vm.count("elements")) opt_elements = vm["elements"].as<std::vector<std::string>>();
+    if (vm.count("output")) opt_output = vm["output"].as<std::string>();
+    if (vm.count("shard"))
+    {
+        opt_shard = shard::parse_shard(vm["shard"].as<std::string>());
+        if (!vm.count("manifest")) throw std::invalid_argument("--shard needs --manifest");
+        if (!opt_input.empty() || !opt_serve.empty()) throw std::invalid_argument("--shard is not supported with --input or --serve");
+        opt_manifest = vm["manifest"].as<std::string>();
+    }
 }
 
-template <std::random_access_iterator TIter>
-void output_each_perm(const TIter first, const TIter last, const std::any &user_data)
+// Where printed output goes: stdout or --output, through a parallel compressor with --compress.
+class stdout_sink
 {
-    auto pCount = std::any_cast<int64_t *>(user_data);
-    if (pCount) [[likely]] (*pCount)++;
-    if (!opt_count)
+public:
+    stdout_sink()
+    {
+        if (!opt_output.empty())
+        {
+            file_.open(opt_output, std::ios::binary);
+            if (!file_) throw std::runtime_error("cannot open " + opt_output);
+        }
+        if (opt_compress != compress::codec::none)
+        {
+            compressor_ = std::make_unique<compress::parallel_compressor>(
+                raw_sink(), opt_compress, opt_compress_level, permutation_parallel::worker_count(opt_compress_threads));
+        }
+    }
+
+    // Thread-safe.
+    block_sink_type sink()
+    {
+        return compressor_ ? compressor_->sink() : raw_sink();
+    }
+
+    // Wait for the compressor and write the frame index if asked to.
+    void finish()
     {
-        for (auto it = first; it != last; ++it) std::cout << *it << " ";
-        std::cout << "\n";
+        if (compressor_)
+        {
+            compressor_->finish();
+            if (!opt_compress_index.empty())
+            {
+                std::ofstream index(opt_compress_index);
+                for (const auto &f : compressor_->frames()) index << f.raw << " " << f.compressed << "\n";
+                if (!index.flush()) throw std::runtime_error("cannot write " + opt_compress_index);
+            }
+        }
+        if (file_.is_open() && !file_.flush()) throw std::runtime_error("cannot write " + opt_output);
     }
+
+    // FNV-1a of the bytes written so far, after compression.
+    std::uint64_t hash() const { return hash_; }
+
+private:
+    block_sink_type raw_sink()
+    {
+        return [this](const std::string_view block) {
+            std::lock_guard lock(mutex_);
+            (file_.is_open() ? static_cast<std::ostream &>(file_) : std::cout).write(block.data(), block.size());
+            hash_ = checksum::fnv1a(block, hash_);
+        };
+    }
+
+    std::mutex mutex_;
+    std::ofstream file_;
+    std::uint64_t hash_ = checksum::fnv1a_offset;
+    std::unique_ptr<compress::parallel_compressor> compressor_;
+};
+
+// Per-thread state passed to output_each_perm as user data.
+struct worker_state
+{
+    alignas(64) int64_t count = 0;
+    bool checksum = false;
+    checksum::digest digest;
+    std::unique_ptr<output_buffer> out; // null when counting only
+};
+
+template <std::random_access_iterator TIter>
+void output_each_perm(const TIter first, const TIter last, const std::any &user_data)
+{
+    auto w = std::any_cast<worker_state *>(user_data);
+    w->count++;
+    if (w->checksum) w->digest.add(first, last);
+    if (w->out) w->out->append(first, last);
+}
+
+// Return whether no element of elems repeats.
+bool all_distinct(perm_type elems)
+{
+    std::sort(std::begin(elems), std::end(elems));
+    return std::adjacent_find(std::cbegin(elems), std::cend(elems)) == std::cend(elems);
 }
 
 void run_perm()
 {
     std::vector<elem_type> elems;
     std::copy(std::cbegin(opt_elements), std::cend(opt_elements), std::back_inserter(elems));
-    int64_t count = 0;
 
-    if (opt_algorithm == "std")
+    // Lexicographic ranges and tables rank n! permutations, but a single run of
+    // std::next_permutation skips repeated ones, so they would print duplicates.
+    const auto repeated = !all_distinct(elems);
+    const auto ranked = opt_table || (opt_threads && permutation_parallel::worker_count(*opt_threads) > 1) || opt_shard.has_value();
+    const auto check_repeated = [&](const registry::perm_order order) {
+        if (ranked && repeated && order == registry::perm_order::lexicographic)
+        {
+            throw std::invalid_argument("repeated elements are not supported with --table, --threads or --shard in lexicographic order");
+        }
+    };
+
+    const auto mode = opt_count ? autotune::mode_count : autotune::mode_print;
+    autotune::choice run{nullptr, 1, output_buffer::default_batch_size};
+    if (opt_algorithm == "auto")
+    {
+        registry::requirements req;
+        req.n = std::size(elems);
+        if (opt_order != "any") req.order = registry::parse_order(opt_order);
+        if (req.order) check_repeated(*req.order);
+        req.parallel = opt_threads.value_or(1) != 1;
+        req.range = opt_shard.has_value();
+        req.repeated = repeated;
+        const auto threads = opt_threads ? std::optional(permutation_parallel::worker_count(*opt_threads)) : std::nullopt;
+        const auto prof = autotune::load_profile(opt_profile);
+        if (const auto c = prof ? autotune::choose(*prof, mode, req, threads) : std::nullopt) run = *c;
+        else if (prof) run.batch_size = prof->batch_size;
+        if (!run.engine) run.engine = &registry::select_engine(req);
+    }
+    else
+    {
+        run.engine = &registry::get_engine(opt_algorithm);
+    }
+    if (opt_threads) run.threads = permutation_parallel::worker_count(*opt_threads);
+    if (opt_batch_size) run.batch_size = *opt_batch_size;
+
+    check_repeated(run.engine->properties.order);
+
+    // With --table, the mapped table replaces the engine and has ranges in any order.
+    table::mapped_table tbl;
+    perm_all_function_type perm_all = run.engine->perm_all;
+    perm_range_function_type perm_range = run.engine->perm_range;
+    if (opt_table)
+    {
+        const auto n = static_cast<unsigned int>(std::size(elems));
+        const auto order = run.engine->properties.order;
+        tbl = opt_table_shm ? table::publish(n, order) : table::load(n, order, opt_table_cache, opt_table_verify);
+        perm_all = [&tbl](const perm_iterator_type first, const perm_iterator_type last, output_each_perm_function_type output_each_perm, const std::any &user_data) {
+            tbl.perm_all(first, last, std::move(output_each_perm), user_data);
+        };
+        perm_range = [&tbl](const perm_iterator_type first, const perm_iterator_type last, const rank_type rank_first, const rank_type rank_last,
+            output_each_perm_function_type output_each_perm, const std::any &user_data) {
+            tbl.perm_range(first, last, rank_first, rank_last, std::move(output_each_perm), user_data);
+        };
+    }
+    if (run.threads > 1 && !opt_table && !run.engine->properties.supports_parallel)
+    {
+        throw std::domain_error("algorithm "s + run.engine->name + " does not support threads");
+    }
+
+    if (opt_shard)
     {
-        using namespace permutation_std;
-        perm_all(std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>, &count);
+        if (!opt_table && (!run.engine->properties.supports_range || std::size(elems) > permutation_rank::max_rank_n))
+        {
+            throw std::domain_error("algorithm "s + run.engine->name + " does not support ranges of " + std::to_string(std::size(elems)) + " elements");
+        }
+        if (run.threads > 1 || opt_pipeline || opt_ordered) throw std::invalid_argument("--shard runs on one thread; run more shards instead");
     }
-    else if (opt_algorithm == "1")
+
+    stdout_sink out;
+    const auto sink = out.sink();
+    std::vector<worker_state> workers(run.threads);
+    std::vector<std::any> worker_data;
+    for (auto &w : workers)
     {
-        using namespace permutation1;
-        perm_all(std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>, &count);
+        if (!opt_count) w.out = std::make_unique<output_buffer>(sink, run.batch_size);
+        w.checksum = opt_checksum || opt_shard;
+        worker_data.emplace_back(&w);
     }
-    else if (opt_algorithm == "2")
+
+    shard::manifest manifest;
+    if (opt_shard)
     {
-        using namespace permutation2;
-        perm_all(std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>, &count);
+        const auto [lo, hi] = shard::shard_range(permutation_rank::factorial(static_cast<unsigned int>(std::size(elems))), *opt_shard);
+        perm_range(std::cbegin(elems), std::cend(elems), lo, hi, output_each_perm<perm_iterator_type>, worker_data[0]);
+        manifest.algorithm = run.engine->name;
+        manifest.order = registry::to_string(run.engine->properties.order);
+        manifest.n = std::size(elems);
+        manifest.elements_hash = shard::elements_hash(std::cbegin(elems), std::cend(elems));
+        manifest.shard = *opt_shard;
+        manifest.rank_first = lo;
+        manifest.rank_last = hi;
+        manifest.output = opt_output;
     }
-    else if (opt_algorithm == "3")
+    else if (opt_pipeline && !opt_count)
     {
-        using namespace permutation3;
-        perm_all(std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>, &count);
+        if (run.threads > 1) throw std::invalid_argument("--pipeline uses one generator thread; use --consumers instead of --threads");
+        pipeline::reorder_sink ordered(sink);
+        pipeline::run(perm_all, std::cbegin(elems), std::cend(elems), opt_pipeline_options,
+            [&](const pipeline::perm_batch &b, unsigned int) {
+                std::string text;
+                for (std::size_t i = 0; i < b.count; ++i) format_perm(text, b.perm_begin(i), b.perm_end(i));
+                ordered.write(b.seq, std::move(text));
+            });
     }
-    else if (opt_algorithm == "4")
+    else if (opt_numa && run.threads > 1)
     {
-        using namespace permutation4;
-        perm_all(std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>, &count);
+        // Worker states are created on the pinned threads; workers is left unused.
+        std::mutex states_mutex;
+        std::vector<std::unique_ptr<worker_state>> states;
+        const auto report = numa::perm_all(perm_range, std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>,
+            [&](const numa::worker &) -> std::any {
+                auto w = std::make_unique<worker_state>();
+                w->checksum = opt_checksum;
+                if (!opt_count) w->out = std::make_unique<output_buffer>(sink, run.batch_size);
+                std::lock_guard lock(states_mutex);
+                states.push_back(std::move(w));
+                return states.back().get();
+            },
+            run.threads);
+        for (auto &w : states)
+        {
+            if (w->out) w->out->flush();
+            workers[0].count += w->count;
+            workers[0].digest += w->digest;
+        }
+        for (const auto &r : report)
+        {
+            std::cerr << "node " << r.node_id << ": " << r.workers << " threads, " << r.perms << " permutations in " << r.seconds << " s, "
+                << r.perms_per_second() << " permutations/s\n";
+        }
+    }
+    else if (opt_ordered && !opt_count && run.threads > 1)
+    {
+        permutation_parallel::perm_all_ordered(perm_range, std::cbegin(elems), std::cend(elems),
+            [](const perm_iterator_type first, const perm_iterator_type last, const std::any &user_data) {
+                format_perm(*std::any_cast<std::string *>(user_data), first, last);
+            },
+            sink, run.threads);
+    }
+    else if (run.threads == 1)
+    {
+        perm_all(std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>, worker_data[0]);
     }
     else
     {
-        throw std::domain_error("unknown algorithm "s + opt_algorithm);
+        permutation_parallel::perm_all(perm_range, std::cbegin(elems), std::cend(elems), output_each_perm<perm_iterator_type>, worker_data);
+    }
+
+    int64_t count = 0;
+    checksum::digest digest;
+    for (auto &w : workers)
+    {
+        if (w.out) w.out->flush();
+        count += w.count;
+        digest += w.digest;
+    }
+    out.finish();
+    if (opt_checksum) std::cout << count << " " << checksum::to_string(digest) << "\n";
+    else if (opt_count) std::cout << count << "\n";
+    if (opt_shard)
+    {
+        manifest.count = static_cast<rank_type>(count);
+        manifest.digest = digest;
+        manifest.output_hash = out.hash();
+        shard::save_manifest(opt_manifest, manifest);
+    }
+}
+
+// Enumerate each line of opt_input as a separate problem.
+void run_stream()
+{
+    if (opt_threads.value_or(1) != 1) throw std::invalid_argument("--threads is not supported with --input");
+
+    std::ifstream file;
+    if (opt_input != "-")
+    {
+        file.open(opt_input);
+        if (!file) throw std::runtime_error("cannot open " + opt_input);
+    }
+    auto &is = opt_input == "-" ? std::cin : file;
+
+    std::optional<autotune::profile> prof;
+    std::optional<registry::perm_order> order;
+    if (opt_algorithm == "auto")
+    {
+        prof = autotune::load_profile(opt_profile);
+        if (opt_order != "any") order = registry::parse_order(opt_order);
     }
+    const auto batch_size = opt_batch_size.value_or(prof ? prof->batch_size : output_buffer::default_batch_size);
+    stdout_sink sink;
+    output_buffer out(sink.sink(), batch_size);
+    job_runner runner(opt_algorithm, order, prof ? &*prof : nullptr, opt_count ? nullptr : &out);
+
+    std::string line;
+    perm_type elems;
+    while (std::getline(is, line))
+    {
+        split_elements(line, elems);
+        if (elems.empty()) continue;
+        const auto count = runner.run(elems);
+        if (opt_count) out.append_raw(std::to_string(count) + "\n");
+        else out.append_raw("\n");
+    }
+    if (is.bad()) throw std::runtime_error("cannot read " + opt_input);
+    out.flush();
+    sink.finish();
+}
 
-    if (opt_count) std::cout << count << "\n";
+// Serve jobs on the socket opt_serve until SIGINT or SIGTERM.
+void run_server()
+{
+    // Signals are taken by a dedicated thread, so that stopping is not done in a signal handler.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    server::server srv(opt_serve, permutation_parallel::worker_count(opt_threads.value_or(0)), autotune::load_profile(opt_profile));
+    std::thread signal_thread([&] {
+        int sig;
+        sigwait(&signals, &sig);
+        srv.stop();
+    });
+    srv.run();
+    signal_thread.join();
+}
+
+// permutation autotune [options]: benchmark the engines and write a profile.
+int run_autotune(int argc, char *argv[])
+{
+    using namespace boost::program_options;
+
+    autotune::options tune;
+    options_description opts("autotune options");
+    opts.add_options()
+        ("profile", value<std::string>()->default_value(autotune::default_profile_path().string()), "Profile to write.")
+        ("min-n", value<std::size_t>(&tune.min_n)->default_value(tune.min_n), "Smallest number of elements to measure.")
+        ("max-n", value<std::size_t>(&tune.max_n)->default_value(tune.max_n), "Largest number of elements to measure.")
+        ("max-threads", value<unsigned int>(&tune.max_threads)->default_value(tune.max_threads), "Largest number of threads to measure.")
+        ("min-time", value<int>()->default_value(static_cast<int>(tune.min_time.count())), "Milliseconds to run each measurement for.")
+        ("help,H", "Print this help.")
+    ;
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opts).run(), vm);
+    notify(vm);
+    if (vm.count("help"))
+    {
+        std::cout << opts << std::endl;
+        return 1;
+    }
+    if (tune.min_n == 0 || tune.min_n > tune.max_n || tune.max_n > permutation_rank::max_rank_n) throw std::invalid_argument("bad range of n");
+    if (tune.max_threads == 0) throw std::invalid_argument("max threads must be positive");
+    tune.min_time = std::chrono::milliseconds(vm["min-time"].as<int>());
+
+    const auto prof = autotune::run(tune, &std::cerr);
+    const auto path = vm["profile"].as<std::string>();
+    autotune::save_profile(path, prof);
+    std::cerr << "wrote " << path << std::endl;
+    return 0;
+}
+
+// permutation verify-shards [options] MANIFEST...: check that the shards cover every
+// permutation exactly once and optionally join their outputs in rank order.
+int run_verify_shards(int argc, char *argv[])
+{
+    using namespace boost::program_options;
+
+    options_description opts("verify-shards options");
+    opts.add_options()
+        ("check-outputs", "Also check the checksum of each shard's output file.")
+        ("merge", value<std::string>(), "Concatenate the shards' output files in rank order into this file.")
+        ("manifests", value<std::vector<std::string>>(), "Manifests written by --shard.")
+        ("help,H", "Print this help.")
+    ;
+    positional_options_description args;
+    args.add("manifests", -1);
+    variables_map vm;
+    store(command_line_parser(argc, argv).options(opts).positional(args).run(), vm);
+    notify(vm);
+    if (vm.count("help") || !vm.count("manifests"))
+    {
+        std::cout << "usage: permutation verify-shards [options] MANIFEST...\n" << opts << std::endl;
+        return 1;
+    }
+
+    std::vector<shard::manifest> manifests;
+    for (const auto &path : vm["manifests"].as<std::vector<std::string>>()) manifests.push_back(shard::load_manifest(path));
+    const auto [total, digest] = shard::verify(manifests);
+
+    const bool check = vm.count("check-outputs");
+    std::ofstream merged;
+    if (vm.count("merge"))
+    {
+        merged.open(vm["merge"].as<std::string>(), std::ios::binary);
+        if (!merged) throw std::runtime_error("cannot open " + vm["merge"].as<std::string>());
+    }
+    if (check || merged.is_open())
+    {
+        std::vector<char> buf(1 << 16);
+        for (const auto &m : manifests)
+        {
+            if (m.output.empty()) throw std::runtime_error("shard " + std::to_string(m.shard.index) + " was written to stdout");
+            std::ifstream is(m.output, std::ios::binary);
+            if (!is) throw std::runtime_error("cannot open " + m.output);
+            auto h = checksum::fnv1a_offset;
+            while (is.read(std::data(buf), std::size(buf)) || is.gcount() > 0)
+            {
+                const std::string_view block(std::data(buf), static_cast<std::size_t>(is.gcount()));
+                h = checksum::fnv1a(block, h);
+                if (merged.is_open()) merged.write(block.data(), block.size());
+            }
+            if (check && h != m.output_hash) throw std::runtime_error(m.output + " does not match its checksum");
+        }
+        if (merged.is_open() && !merged.flush()) throw std::runtime_error("cannot write " + vm["merge"].as<std::string>());
+    }
+    std::cout << std::size(manifests) << " shards cover all " << total << " permutations exactly once\n"
+        << total << " " << checksum::to_string(digest) << "\n";
+    return 0;
+}
+
+// permutation unpublish-table ORDER N: remove the shared memory table published by --table-shm.
+int run_unpublish_table(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        std::cout << "usage: permutation unpublish-table ORDER N" << std::endl;
+        return 1;
+    }
+    table::unpublish(table::shm_name(static_cast<unsigned int>(std::stoul(argv[2])), registry::parse_order(argv[1])));
+    return 0;
 }
 
 int main(int argc, char**argv)
 try
 {
     std::ios::sync_with_stdio(false);
-    using namespace permutation_std;
+    if (argc > 1 && argv[1] == "autotune"s) return run_autotune(argc - 1, argv + 1);
+    if (argc > 1 && argv[1] == "verify-shards"s) return run_verify_shards(argc - 1, argv + 1);
+    if (argc > 1 && argv[1] == "unpublish-table"s) return run_unpublish_table(argc - 1, argv + 1);
     process_cmdline(argc, argv);
-    run_perm();
+    if (!opt_serve.empty()) run_server();
+    else if (!opt_input.empty()) run_stream();
+    else run_perm();
 
     return 0;
 }
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <stdexcept>
 #include <vector>
 #include <algorithm>
@@ -9,7 +11,6 @@
 #include <functional>
 #include <any>
 #include <limits>
-#include <cassert>
 
 namespace permutation_algorithms
 {
@@ -25,6 +26,17 @@ namespace permutation_algorithms
         // Possible implementation use a traditional Algorithm L (Lexicographic permutation generation)
         // written in Knuth, D. The Art of Computer Programming Vol. 4A Combinatorial Algorithms Pt.1
         // 7.2.1.2. Generating all permutations.
+        // [first:last): Elements of any ordered type, permuted in place.
+        // visit: called with first and last for each permutation.
+        template <std::random_access_iterator TIter, typename TVisit>
+        inline void perm_each(const TIter first, const TIter last, TVisit visit)
+        {
+            std::sort(first, last); // a first permutation
+            do {
+                visit(first, last);
+            } while (std::next_permutation(first, last));
+        }
+
         // [first:last): Elements to permute.
         // output_each_perm: output function of which a permutation should be passed as the parameters.
         template <std::random_access_iterator TIter>
@@ -32,11 +44,7 @@ namespace permutation_algorithms
         inline void perm_all(const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
         {
             perm_type a{first, last}; // a simple concatenation makes a permutation
-            std::sort(std::begin(a), std::end(a)); // a first permutation
-            do {
-                output_each_perm(std::cbegin(a), std::cend(a), user_data);
-            } while (std::next_permutation(std::begin(a), std::end(a)));
-            
+            perm_each(std::begin(a), std::end(a), [&](const auto f, const auto l) { output_each_perm(f, l, user_data); });
         }
     }
 
@@ -46,82 +54,106 @@ namespace permutation_algorithms
         // into all positions of permutations of n-1 elements.
         // Knuth, D. The Art of Computer Programming Vol.1 Fundamental Algorithms 3rd Ed.
         // 1.2.5. Permutations and Factorials Method 1
-        // [first:last): Elements to permute.
-        // output_each_perm: output function of which a permutation should be passed as parameters.
-        template <std::random_access_iterator TIter>
-            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
-        inline void perm(const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        // The recursion is unrolled into one digit per level: d[k] in [0:k] is the position
+        // element k was inserted at among elements 0...k, and the last level changes fastest.
+        // A generator can be paused, resumed from its digits, or started at any of them.
+        class generator
         {
-            const auto d = std::distance(first, last);
-            assert(d >= 0);
-            if (d == 0) return;
-            if (d == 1)
+        public:
+            // [first:last): Elements to permute. Starts at the first permutation, all digits 0.
+            template <std::random_access_iterator TIter>
+                requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+            generator(const TIter first, const TIter last) : a_(std::make_reverse_iterator(last), std::make_reverse_iterator(first)), d_(std::size(a_), 0)
             {
-                output_each_perm(first, last, user_data);
-                return;
             }
 
-            const auto &new_elem = *std::prev(last);
-            // Generate n-1 elements using recursion.
-            perm(first, std::prev(last),
-                [&](const perm_iterator_type pm_first, const perm_iterator_type pm_last, const std::any &pm_user_data) {
-                    // [pm_first:pm_last) is a permutation of n-1 elements
-                    perm_type cur_perm;
-                    for (size_t i = 0; i < d; ++i)
+            // Starts at the permutation of the given digits, as returned by digits().
+            // Throws std::invalid_argument unless there is one per element and d[k] <= k.
+            template <std::random_access_iterator TIter>
+                requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+            generator(const TIter first, const TIter last, std::vector<int> digits) : d_(std::move(digits))
+            {
+                const auto n = std::distance(first, last);
+                if (std::ssize(d_) != n) throw std::invalid_argument("digits of another size");
+                a_.reserve(n);
+                for (std::ptrdiff_t k = 0; k < n; ++k)
+                {
+                    if (d_[k] < 0 || d_[k] > k) throw std::invalid_argument("digit out of range");
+                    a_.insert(std::next(std::begin(a_), d_[k]), first[k]);
+                }
+            }
+
+            // Step to the next permutation. Returns false, staying at the last one, after n! - 1 steps.
+            bool next()
+            {
+                const auto n = static_cast<int>(std::size(d_));
+                for (int k = n - 1; k > 0; --k)
+                {
+                    if (d_[k] == k) continue;
+                    // Elements k+1... all stand last among their predecessors, so elements
+                    // 0...k lead a_; element k moves one place right among them.
+                    using namespace std;
+                    swap(a_[d_[k]], a_[d_[k] + 1]);
+                    ++d_[k];
+                    if (k + 1 < n)
                     {
-                        // Make a copy with a new element.
-                        cur_perm.clear();
-                        cur_perm.reserve(std::distance(pm_first, pm_last) + 1);
-                        const auto insertion_point = std::next(pm_first, i);
-                        std::copy(pm_first, insertion_point, std::back_inserter(cur_perm));
-                        cur_perm.emplace_back(new_elem);
-                        std::copy(insertion_point, pm_last, std::back_inserter(cur_perm));
-
-                        output_each_perm(std::cbegin(cur_perm), std::cend(cur_perm), pm_user_data);
+                        // Elements k+1... are inserted at the front again, the last one first.
+                        std::rotate(std::begin(a_), std::next(std::begin(a_), k + 1), std::end(a_));
+                        std::reverse(std::begin(a_), std::next(std::begin(a_), n - k - 1));
+                        std::fill(std::next(std::begin(d_), k + 1), std::end(d_), 0);
                     }
-                },
-                user_data
-            );
-        }
+                    return true;
+                }
+                return false;
+            }
+
+            perm_iterator_type begin() const { return std::cbegin(a_); }
+            perm_iterator_type end() const { return std::cend(a_); }
+            std::size_t size() const { return std::size(a_); }
+            // The state to resume from: d[k] is where element k stands among elements 0...k.
+            const std::vector<int> &digits() const { return d_; }
+
+        private:
+            perm_type a_;
+            std::vector<int> d_;
+        };
+
+        // [first:last): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
         template <std::random_access_iterator TIter>
             requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
         inline void perm_all(const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
         {
-            perm_type c{first, last}; // copy
-            perm(std::begin(c), std::end(c), output_each_perm, user_data);
+            if (first == last) return;
+            generator g(first, last);
+            do {
+                output_each_perm(std::cbegin(g), std::cend(g), user_data);
+            } while (g.next());
         }
     }
 
     namespace permutation2
     {
-        // Permutation generation.
-        // Knuth, D. The Art of Computer Programming Vol. 4A Combinatorial Algorithms Pt.1
-        // 7.2.1.2 Generating all permutations. Algorithm P (Plain change)
-        // [first:last): Elements to permute.
-        // output_each_perm: output function of which a permutation should be passed as parameters.
-        template <std::random_access_iterator TIter>
-            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
-        inline void perm_all(const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        // Algorithm P on positions only: call on_swap(i) for each of the n! - 1 swaps of
+        // positions i and i + 1 that step perm_all's order, starting from the input order.
+        // Lets callers keep state that changes by O(1) per adjacent transposition.
+        template <typename TSwap>
+        inline void perm_adjacent_swaps(const int n, TSwap on_swap)
         {
-            const auto sz = std::distance(first, last);
-            if (sz > std::numeric_limits<int>::max()) throw std::domain_error("too many elements");
-            if (sz == 0) return;
+            if (n <= 1) return;
 
-            perm_type a{first, last};
-            std::vector<int> c(sz, 0);
-            std::vector<signed char> o(sz, 1);
+            std::vector<int> c(n, 0);
+            std::vector<signed char> o(n, 1);
             for (;;)
             {
-                output_each_perm(std::cbegin(a), std::cend(a), user_data);
-                for (int s = 0, j = sz - 1, q; ; --j)
+                for (int s = 0, j = n - 1, q; ; --j)
                 {
                     q = c[j] + o[j];
                     if (q >= 0)
                     {
                         if (q != j + 1)
                         {
-                            using namespace std;
-                            swap(a[j - c[j] + s], a[j - q + s]);
+                            on_swap(j - std::max(c[j], q) + s);
                             c[j] = q;
                             break;
                         }
@@ -133,6 +165,35 @@ namespace permutation_algorithms
             }
             /* NOTREACHED */
         }
+
+        // Permutation generation.
+        // Knuth, D. The Art of Computer Programming Vol. 4A Combinatorial Algorithms Pt.1
+        // 7.2.1.2 Generating all permutations. Algorithm P (Plain change)
+        // [first:last): Elements of any type, permuted in place.
+        // visit: called with first and last for each permutation.
+        template <std::random_access_iterator TIter, typename TVisit>
+        inline void perm_each(const TIter first, const TIter last, TVisit visit)
+        {
+            const auto sz = std::distance(first, last);
+            if (sz > std::numeric_limits<int>::max()) throw std::domain_error("too many elements");
+            if (sz == 0) return;
+
+            visit(first, last);
+            perm_adjacent_swaps(static_cast<int>(sz), [&](const int i) {
+                std::iter_swap(std::next(first, i), std::next(first, i + 1));
+                visit(first, last);
+            });
+        }
+
+        // [first:last): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm_all(const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            perm_type a{first, last};
+            perm_each(std::begin(a), std::end(a), [&](const auto f, const auto l) { output_each_perm(f, l, user_data); });
+        }
     }
 
     namespace permutation3
@@ -179,14 +240,15 @@ namespace permutation_algorithms
         // Permutation generation.
         // Heap, B. R. (1963) "Permutations by Interchanges". The Computer Journal 6(3): 293-4.
         // Non-recursive version.
-        // [first:last): Elements to permute.
-        // output_each_perm: output function of which a permutation should be passed as parameters.
-        template <std::random_access_iterator TIter>
-            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
-        inline void perm(const int n, const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        // [first:last): Elements of any type, permuted in place.
+        // visit: called with first and last for each permutation.
+        template <std::random_access_iterator TIter, typename TVisit>
+        inline void perm_each(const TIter first, const TIter last, TVisit visit)
         {
+            const auto n = std::distance(first, last);
+            if (n > std::numeric_limits<int>::max()) throw std::domain_error("too many elements");
             std::vector<int> c(n, 0);
-            output_each_perm(first, last, user_data);
+            visit(first, last);
             for (int i = 1; i < n;)
             {
                 if (c[i] < i)
@@ -194,7 +256,7 @@ namespace permutation_algorithms
                     using namespace std;
                     if ((i&1) == 0) swap(first[0], first[i]);
                     else swap(first[c[i]], first[i]);
-                    output_each_perm(first, last, user_data);
+                    visit(first, last);
                     ++c[i];
                     i = 1;
                 }
@@ -206,6 +268,15 @@ namespace permutation_algorithms
             }
         }
 
+        // [first:first+n): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm(const int n, const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            perm_each(first, std::next(first, n), [&](const TIter f, const TIter) { output_each_perm(f, last, user_data); });
+        }
+
         // [first:last): Elements to permute.
         // output_each_perm: output function of which a permutation should be passed as parameters.
         template <std::random_access_iterator TIter>
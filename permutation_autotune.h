@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "permutation.h"
+#include "permutation_output.h"
+#include "permutation_parallel.h"
+#include "permutation_registry.h"
+
+namespace permutation_algorithms
+{
+    namespace autotune
+    {
+        // Visitor costs a profile is measured with: "count" only counts permutations,
+        // "print" formats them as text like main.cpp does.
+        constexpr std::string_view mode_count = "count";
+        constexpr std::string_view mode_print = "print";
+
+        // Measured throughput of one engine for one mode and number of elements.
+        struct profile_entry
+        {
+            std::string mode;
+            std::size_t n;
+            std::string engine;
+            unsigned int threads;
+            double ns_per_perm;
+        };
+
+        struct profile
+        {
+            std::size_t batch_size = output_buffer::default_batch_size;
+            std::vector<profile_entry> entries;
+        };
+
+        // The profile is a text file of lines
+        //   batch_size <bytes>
+        //   entry <mode> <n> <engine> <threads> <ns per permutation>
+        // Blank lines and lines starting with # are ignored.
+        inline void write_profile(std::ostream &os, const profile &prof)
+        {
+            os << "# permutation autotune profile\n";
+            os << "batch_size " << prof.batch_size << "\n";
+            for (const auto &e : prof.entries)
+            {
+                os << "entry " << e.mode << " " << e.n << " " << e.engine << " " << e.threads << " " << e.ns_per_perm << "\n";
+            }
+        }
+
+        // Throws std::runtime_error on a malformed profile.
+        inline profile read_profile(std::istream &is)
+        {
+            profile prof;
+            std::string line;
+            for (int lineno = 1; std::getline(is, line); ++lineno)
+            {
+                std::istringstream ls(line);
+                std::string key;
+                if (!(ls >> key) || key[0] == '#') continue;
+                if (key == "batch_size")
+                {
+                    if (!(ls >> prof.batch_size) || prof.batch_size == 0) throw std::runtime_error("bad batch_size in profile line " + std::to_string(lineno));
+                }
+                else if (key == "entry")
+                {
+                    profile_entry e;
+                    if (!(ls >> e.mode >> e.n >> e.engine >> e.threads >> e.ns_per_perm) || e.threads == 0)
+                    {
+                        throw std::runtime_error("bad entry in profile line " + std::to_string(lineno));
+                    }
+                    prof.entries.emplace_back(std::move(e));
+                }
+                else
+                {
+                    throw std::runtime_error("unknown key " + key + " in profile line " + std::to_string(lineno));
+                }
+            }
+            return prof;
+        }
+
+        // $PERMUTATION_PROFILE, or permutation/profile under the XDG config directory.
+        inline std::filesystem::path default_profile_path()
+        {
+            if (const auto p = std::getenv("PERMUTATION_PROFILE"); p && *p) return p;
+            if (const auto p = std::getenv("XDG_CONFIG_HOME"); p && *p) return std::filesystem::path(p) / "permutation" / "profile";
+            if (const auto p = std::getenv("HOME"); p && *p) return std::filesystem::path(p) / ".config" / "permutation" / "profile";
+            return "permutation.profile";
+        }
+
+        // Return the profile at path, or nullopt if there is none.
+        inline std::optional<profile> load_profile(const std::filesystem::path &path)
+        {
+            std::ifstream is(path);
+            if (!is) return std::nullopt;
+            return read_profile(is);
+        }
+
+        inline void save_profile(const std::filesystem::path &path, const profile &prof)
+        {
+            if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path());
+            std::ofstream os(path);
+            write_profile(os, prof);
+            if (!os.flush()) throw std::runtime_error("cannot write profile " + path.string());
+        }
+
+        // What --algorithm auto runs with.
+        struct choice
+        {
+            const registry::engine *engine;
+            unsigned int threads;
+            std::size_t batch_size;
+        };
+
+        // Choose the fastest measured engine satisfying req for mode, using the entries
+        // measured at the largest n not above req.n (or the smallest n if all are above).
+        // With threads, only entries measured on that many threads are used.
+        // Return nullopt if the profile has nothing usable.
+        inline std::optional<choice> choose(const profile &prof, const std::string_view mode, const registry::requirements &req,
+            const std::optional<unsigned int> threads = std::nullopt)
+        {
+            auto usable = [&](const profile_entry &e) -> const registry::engine * {
+                if (e.mode != mode || (threads && e.threads != *threads)) return nullptr;
+                const auto engine = registry::find_engine(e.engine);
+                if (!engine) return nullptr;
+                auto r = req;
+                if (e.threads > 1)
+                {
+                    // Parallel chunks interleave, so printing in a required order stays sequential.
+                    if (req.order && mode == mode_print) return nullptr;
+                    r.parallel = true;
+                }
+                return registry::satisfies(*engine, r) ? engine : nullptr;
+            };
+
+            std::optional<std::size_t> below, above;
+            for (const auto &e : prof.entries)
+            {
+                if (!usable(e)) continue;
+                if (e.n <= req.n) below = std::max(below.value_or(0), e.n);
+                else above = std::min(above.value_or(e.n), e.n);
+            }
+            const auto n = below ? below : above;
+            if (!n) return std::nullopt;
+
+            const profile_entry *best = nullptr;
+            for (const auto &e : prof.entries)
+            {
+                if (e.n != *n || !usable(e)) continue;
+                if (!best || e.ns_per_perm < best->ns_per_perm) best = &e;
+            }
+            return choice{registry::find_engine(best->engine), best->threads, prof.batch_size};
+        }
+
+        struct options
+        {
+            std::size_t min_n = 4;
+            std::size_t max_n = 10;
+            unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+            std::chrono::milliseconds min_time{50};
+        };
+
+        namespace detail
+        {
+            struct bench_worker
+            {
+                alignas(64) int64_t count = 0;
+                std::optional<output_buffer> out;
+            };
+
+            inline void bench_each_perm(const perm_iterator_type first, const perm_iterator_type last, const std::any &user_data)
+            {
+                auto w = std::any_cast<bench_worker *>(user_data);
+                ++w->count;
+                if (w->out) w->out->append(first, last);
+            }
+
+            // Return nanoseconds per permutation of running engine on n elements
+            // repeatedly for at least min_time. Printed output goes to null_sink.
+            inline double measure(const registry::engine &engine, const std::size_t n, const unsigned int threads,
+                const std::string_view mode, const std::size_t batch_size, const block_sink_type &null_sink, const std::chrono::milliseconds min_time)
+            {
+                std::vector<std::string> strings;
+                for (std::size_t i = 0; i < n; ++i) strings.emplace_back(1, 'e').append(std::to_string(i));
+                const perm_type elems(std::cbegin(strings), std::cend(strings));
+
+                std::vector<bench_worker> workers(threads);
+                std::vector<std::any> worker_data;
+                for (auto &w : workers)
+                {
+                    if (mode == mode_print) w.out.emplace(null_sink, batch_size);
+                    worker_data.emplace_back(&w);
+                }
+
+                using clock = std::chrono::steady_clock;
+                const auto start = clock::now();
+                auto elapsed = clock::duration::zero();
+                int64_t perms = 0;
+                do
+                {
+                    if (threads == 1)
+                    {
+                        engine.perm_all(std::cbegin(elems), std::cend(elems), bench_each_perm, worker_data[0]);
+                    }
+                    else
+                    {
+                        permutation_parallel::perm_all(engine.perm_range, std::cbegin(elems), std::cend(elems), bench_each_perm, worker_data);
+                    }
+                    for (auto &w : workers)
+                    {
+                        if (w.out) w.out->flush();
+                        perms += w.count;
+                        w.count = 0;
+                    }
+                    elapsed = clock::now() - start;
+                } while (elapsed < min_time);
+                return std::chrono::duration<double, std::nano>(elapsed).count() / perms;
+            }
+        }
+
+        // Benchmark the registered engines on this host and return the resulting profile.
+        // Progress is written to log if it is not null.
+        inline profile run(const options &opts, std::ostream *log)
+        {
+            std::unique_ptr<std::FILE, decltype(&std::fclose)> devnull(std::fopen("/dev/null", "wb"), &std::fclose);
+            std::mutex devnull_mutex;
+            const block_sink_type null_sink = [&](const std::string_view block) {
+                std::lock_guard lock(devnull_mutex);
+                if (devnull) std::fwrite(block.data(), 1, block.size(), devnull.get());
+            };
+
+            std::vector<unsigned int> thread_counts{1};
+            for (auto t = 2u; t < opts.max_threads; t *= 2) thread_counts.push_back(t);
+            if (opts.max_threads > 1) thread_counts.push_back(opts.max_threads);
+
+            profile prof;
+            for (const auto mode : {mode_count, mode_print})
+            {
+                for (auto n = opts.min_n; n <= opts.max_n; ++n)
+                {
+                    for (const auto &engine : registry::engines())
+                    {
+                        registry::requirements req;
+                        req.n = n;
+                        if (!registry::satisfies(engine, req)) continue;
+                        for (const auto threads : thread_counts)
+                        {
+                            req.parallel = threads > 1;
+                            if (!registry::satisfies(engine, req)) break;
+                            const auto ns = detail::measure(engine, n, threads, mode, prof.batch_size, null_sink, opts.min_time);
+                            prof.entries.push_back({std::string(mode), n, engine.name, threads, ns});
+                            if (log) *log << mode << " n=" << n << " algorithm=" << engine.name << " threads=" << threads << ": " << ns << " ns/perm" << std::endl;
+                        }
+                    }
+                }
+            }
+
+            // Tune the output batch size with the fastest sequential printing engine at max_n.
+            // choose() may pick a threaded entry, whose engine is not the fastest on one thread.
+            const profile_entry *fastest = nullptr;
+            for (const auto &e : prof.entries)
+            {
+                if (e.mode != mode_print || e.n != opts.max_n || e.threads != 1) continue;
+                if (!fastest || e.ns_per_perm < fastest->ns_per_perm) fastest = &e;
+            }
+            if (fastest)
+            {
+                const auto &engine = registry::get_engine(fastest->engine);
+                double best_ns = 0;
+                for (std::size_t batch_size = 4 * 1024; batch_size <= 1024 * 1024; batch_size *= 4)
+                {
+                    const auto ns = detail::measure(engine, opts.max_n, 1, mode_print, batch_size, null_sink, opts.min_time);
+                    if (log) *log << "batch_size=" << batch_size << ": " << ns << " ns/perm" << std::endl;
+                    if (best_ns == 0 || ns < best_ns)
+                    {
+                        best_ns = ns;
+                        prof.batch_size = batch_size;
+                    }
+                }
+            }
+            return prof;
+        }
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "permutation.h"
+#include "permutation_parallel.h"
+
+namespace permutation_algorithms
+{
+    // Branch and bound over the lexicographic prefix tree: the children of a prefix append
+    // each remaining element in input order, so with sorted input the leaves are visited
+    // in lexicographic order. A subtree is skipped when the lower bound of its prefix is
+    // no better than the best complete permutation found so far, the incumbent.
+    namespace bnb
+    {
+        // Cost of a complete permutation; lower is better.
+        using cost_function_type = std::function<double(const perm_iterator_type, const perm_iterator_type)>;
+
+        // A lower bound of the cost of every permutation starting with the prefix
+        // [prefix_first:prefix_last), whose remaining elements are [rest_first:rest_last).
+        using bound_function_type = std::function<double(const perm_iterator_type prefix_first, const perm_iterator_type prefix_last,
+            const perm_iterator_type rest_first, const perm_iterator_type rest_last)>;
+
+        struct report
+        {
+            perm_type best;                 // Empty if no permutation beat the initial incumbent.
+            double cost = std::numeric_limits<double>::infinity();
+            std::uint64_t nodes = 0;        // Prefixes expanded into their children.
+            std::uint64_t pruned = 0;       // Prefixes cut off by their bound.
+            std::uint64_t leaves = 0;       // Permutations whose cost was evaluated.
+            double perms = 0;               // n!, what exhaustive enumeration evaluates.
+        };
+
+        // Find a permutation of [first:last) of least cost with threads workers, or none
+        // if none costs less than incumbent. Subtrees near the root are tasks in per-worker
+        // deques: a worker takes its newest task, depth first, and an idle worker steals
+        // the oldest, largest task of another. Throws what cost or bound throws.
+        inline report solve(const perm_iterator_type first, const perm_iterator_type last, const cost_function_type &cost,
+            const bound_function_type &bound, const unsigned int threads = 1, const double incumbent = std::numeric_limits<double>::infinity())
+        {
+            const auto n = static_cast<std::size_t>(std::distance(first, last));
+            const auto workers = std::max(1u, threads);
+
+            struct task
+            {
+                perm_type a;                // Prefix a[0:depth), then the remaining elements.
+                std::size_t depth;
+            };
+            struct alignas(64) task_queue
+            {
+                std::mutex mutex;
+                std::deque<task> tasks;
+            };
+            std::vector<task_queue> queues(workers);
+
+            // Prefixes up to spawn_depth long become tasks; below, workers recurse.
+            // Deep enough for permutation_parallel::chunks_per_worker tasks per worker.
+            std::size_t spawn_depth = 0;
+            if (workers > 1)
+            {
+                for (double subtrees = 1; spawn_depth + 1 < n && subtrees < double(workers) * permutation_parallel::chunks_per_worker; )
+                {
+                    subtrees *= double(n - spawn_depth++);
+                }
+            }
+
+            std::atomic<double> best_cost{incumbent};
+            std::mutex best_mutex;
+            report r;
+            r.perms = 1;
+            for (std::size_t k = 2; k <= n; ++k) r.perms *= double(k);
+
+            std::atomic<std::size_t> pending{1};    // Tasks queued or running.
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+            queues[0].tasks.push_back({perm_type(first, last), 0});
+
+            auto work = [&](const unsigned int self) {
+                std::uint64_t nodes = 0, pruned = 0, leaves = 0;
+
+                auto explore = [&](auto &self_explore, perm_type &a, const std::size_t depth) -> void {
+                    if (depth == n)
+                    {
+                        ++leaves;
+                        const auto c = cost(std::cbegin(a), std::cend(a));
+                        if (c < best_cost.load(std::memory_order_relaxed))
+                        {
+                            std::lock_guard lock(best_mutex);
+                            if (c < best_cost.load(std::memory_order_relaxed))
+                            {
+                                r.best = a;
+                                r.cost = c;
+                                best_cost.store(c, std::memory_order_relaxed);
+                            }
+                        }
+                        return;
+                    }
+                    ++nodes;
+                    std::vector<task> spawned;
+                    const auto d = std::next(std::begin(a), depth);
+                    for (auto i = depth; i < n && !failed.load(std::memory_order_relaxed); ++i)
+                    {
+                        // Bring a[i] to the end of the prefix, keeping the rest in order.
+                        const auto e = std::next(std::begin(a), i);
+                        std::rotate(d, e, std::next(e));
+                        const auto child = std::next(d);
+                        if (depth + 1 < n && bound(std::cbegin(a), child, child, std::cend(a)) >= best_cost.load(std::memory_order_relaxed))
+                        {
+                            ++pruned;
+                        }
+                        else if (depth + 1 <= spawn_depth)
+                        {
+                            spawned.push_back({a, depth + 1});
+                        }
+                        else
+                        {
+                            self_explore(self_explore, a, depth + 1);
+                        }
+                        std::rotate(d, std::next(d), std::next(e));
+                    }
+                    if (spawned.empty()) return;
+                    // Newest last, so that the owner takes the first child first.
+                    pending += std::size(spawned);
+                    std::lock_guard lock(queues[self].mutex);
+                    std::move(std::rbegin(spawned), std::rend(spawned), std::back_inserter(queues[self].tasks));
+                };
+
+                auto take = [&](task &t) {
+                    for (unsigned int k = 0; k < workers; ++k)
+                    {
+                        auto &q = queues[(self + k) % workers];
+                        std::lock_guard lock(q.mutex);
+                        if (q.tasks.empty()) continue;
+                        if (k == 0)
+                        {
+                            t = std::move(q.tasks.back());
+                            q.tasks.pop_back();
+                        }
+                        else
+                        {
+                            t = std::move(q.tasks.front());
+                            q.tasks.pop_front();
+                        }
+                        return true;
+                    }
+                    return false;
+                };
+
+                while (pending.load() > 0)
+                {
+                    task t;
+                    if (!take(t))
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    try
+                    {
+                        if (!failed.load(std::memory_order_relaxed)) explore(explore, t.a, t.depth);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard lock(best_mutex);
+                        if (!error) error = std::current_exception();
+                        failed = true;
+                    }
+                    --pending;
+                }
+
+                std::lock_guard lock(best_mutex);
+                r.nodes += nodes;
+                r.pruned += pruned;
+                r.leaves += leaves;
+            };
+
+            std::vector<std::thread> pool;
+            for (unsigned int i = 1; i < workers; ++i) pool.emplace_back(work, i);
+            work(0);
+            for (auto &t : pool) t.join();
+            if (error) std::rethrow_exception(error);
+            return r;
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "permutation.h"
+
+namespace permutation_algorithms
+{
+    namespace checksum
+    {
+        // 64-bit FNV-1a, continuing from h.
+        constexpr std::uint64_t fnv1a_offset = 14695981039346656037ull;
+        constexpr std::uint64_t fnv1a_prime = 1099511628211ull;
+        constexpr std::uint64_t fnv1a(const std::string_view s, std::uint64_t h = fnv1a_offset)
+        {
+            for (const auto c : s)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= fnv1a_prime;
+            }
+            return h;
+        }
+
+        // The splitmix64 finalizer: every input bit affects every output bit.
+        constexpr std::uint64_t mix(std::uint64_t x)
+        {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ull;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebull;
+            x ^= x >> 31;
+            return x;
+        }
+
+        // Hash of one permutation, from its elements in order. Engines that permute
+        // the same elements give the same hash for the same permutation.
+        template <std::input_iterator TIter>
+        inline std::uint64_t perm_hash(const TIter first, const TIter last)
+        {
+            std::uint64_t h = fnv1a_offset;
+            for (auto it = first; it != last; ++it) h = mix(h ^ fnv1a(*it));
+            return h;
+        }
+
+        // Order-independent checksum of a set of permutations: the sums of two hashes
+        // of each permutation. Digests of disjoint parts of an enumeration add up to the
+        // digest of the whole, whichever thread, shard or engine produced them.
+        struct digest
+        {
+            std::uint64_t sum = 0;
+            std::uint64_t sum2 = 0;
+
+            template <std::input_iterator TIter>
+            void add(const TIter first, const TIter last)
+            {
+                const auto h = perm_hash(first, last);
+                sum += h;
+                sum2 += mix(h ^ 0x9e3779b97f4a7c15ull);
+            }
+
+            digest &operator+=(const digest &other)
+            {
+                sum += other.sum;
+                sum2 += other.sum2;
+                return *this;
+            }
+
+            friend bool operator==(const digest &, const digest &) = default;
+        };
+
+        // 32 hexadecimal digits.
+        inline std::string to_string(const digest &d)
+        {
+            static constexpr char digits[] = "0123456789abcdef";
+            std::string r(32, '0');
+            for (int i = 0; i < 16; ++i)
+            {
+                r[15 - i] = digits[(d.sum >> (4 * i)) & 15];
+                r[31 - i] = digits[(d.sum2 >> (4 * i)) & 15];
+            }
+            return r;
+        }
+
+        // Throws std::invalid_argument if s is not what to_string writes.
+        inline digest parse_digest(const std::string_view s)
+        {
+            if (std::size(s) != 32) throw std::invalid_argument("bad checksum " + std::string(s));
+            digest d;
+            for (std::size_t i = 0; i < 32; ++i)
+            {
+                const auto c = s[i];
+                const int v = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+                if (v < 0) throw std::invalid_argument("bad checksum " + std::string(s));
+                auto &part = i < 16 ? d.sum : d.sum2;
+                part = part << 4 | static_cast<std::uint64_t>(v);
+            }
+            return d;
+        }
+    }
+}
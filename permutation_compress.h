@@ -0,0 +1,280 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#ifdef PERMUTATION_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef PERMUTATION_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+#include "permutation_output.h"
+
+namespace permutation_algorithms
+{
+    namespace compress
+    {
+        enum class codec
+        {
+            none,
+            gzip,   // One gzip member per block; gzip -d reads the concatenation.
+            zstd,   // One zstd frame per block.
+            lz4,    // One LZ4 frame per block.
+        };
+
+        inline std::string_view to_string(const codec c)
+        {
+            switch (c)
+            {
+            case codec::none: return "none";
+            case codec::gzip: return "gzip";
+            case codec::zstd: return "zstd";
+            case codec::lz4: return "lz4";
+            }
+            return "unknown";
+        }
+
+        // Whether this build can compress with c.
+        inline bool available(const codec c)
+        {
+            switch (c)
+            {
+            case codec::none:
+            case codec::gzip:
+                return true;
+            case codec::zstd:
+#ifdef PERMUTATION_HAVE_ZSTD
+                return true;
+#else
+                return false;
+#endif
+            case codec::lz4:
+#ifdef PERMUTATION_HAVE_LZ4
+                return true;
+#else
+                return false;
+#endif
+            }
+            return false;
+        }
+
+        // Throws std::domain_error if s names no codec or one this build lacks.
+        inline codec parse_codec(const std::string_view s)
+        {
+            for (const auto c : {codec::none, codec::gzip, codec::zstd, codec::lz4})
+            {
+                if (s != to_string(c)) continue;
+                if (!available(c)) throw std::domain_error("this build has no " + std::string(s) + " support");
+                return c;
+            }
+            throw std::domain_error("unknown compression " + std::string(s));
+        }
+
+        // Compress src into an independent frame appended to dest.
+        // level: codec-specific; 0 picks the codec's default.
+        inline void compress_frame(const codec c, const int level, const std::string_view src, std::string &dest)
+        {
+            const auto start = std::size(dest);
+            switch (c)
+            {
+            case codec::none:
+                dest.append(src);
+                return;
+            case codec::gzip:
+            {
+                z_stream zs{};
+                // windowBits 15 + 16 writes a gzip header and trailer.
+                if (deflateInit2(&zs, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                {
+                    throw std::runtime_error("deflateInit2 failed");
+                }
+                dest.resize(start + deflateBound(&zs, std::size(src)));
+                zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(std::data(src)));
+                zs.avail_in = static_cast<uInt>(std::size(src));
+                zs.next_out = reinterpret_cast<Bytef *>(std::data(dest) + start);
+                zs.avail_out = static_cast<uInt>(std::size(dest) - start);
+                const auto r = deflate(&zs, Z_FINISH);
+                deflateEnd(&zs);
+                if (r != Z_STREAM_END) throw std::runtime_error("deflate failed");
+                dest.resize(start + zs.total_out);
+                return;
+            }
+            case codec::zstd:
+#ifdef PERMUTATION_HAVE_ZSTD
+            {
+                dest.resize(start + ZSTD_compressBound(std::size(src)));
+                const auto r = ZSTD_compress(std::data(dest) + start, std::size(dest) - start, std::data(src), std::size(src), level);
+                if (ZSTD_isError(r)) throw std::runtime_error(std::string("ZSTD_compress: ") + ZSTD_getErrorName(r));
+                dest.resize(start + r);
+                return;
+            }
+#else
+                break;
+#endif
+            case codec::lz4:
+#ifdef PERMUTATION_HAVE_LZ4
+            {
+                LZ4F_preferences_t prefs{};
+                prefs.compressionLevel = level;
+                prefs.frameInfo.contentSize = std::size(src);
+                dest.resize(start + LZ4F_compressFrameBound(std::size(src), &prefs));
+                const auto r = LZ4F_compressFrame(std::data(dest) + start, std::size(dest) - start, std::data(src), std::size(src), &prefs);
+                if (LZ4F_isError(r)) throw std::runtime_error(std::string("LZ4F_compressFrame: ") + LZ4F_getErrorName(r));
+                dest.resize(start + r);
+                return;
+            }
+#else
+                break;
+#endif
+            }
+            throw std::domain_error("this build has no " + std::string(to_string(c)) + " support");
+        }
+
+        // Where a block starts in the uncompressed and in the compressed stream.
+        // Decompression can start at any frame.
+        struct frame_offset
+        {
+            std::uint64_t raw;
+            std::uint64_t compressed;
+        };
+
+        // A block sink that compresses blocks on worker threads and passes the frames
+        // to the downstream sink in the order the blocks were written.
+        // The caller is blocked only while max_pending blocks are waiting, so a
+        // generator keeps running while earlier blocks are compressed.
+        class parallel_compressor
+        {
+        public:
+            parallel_compressor(block_sink_type downstream, const codec c, const int level, const unsigned int threads)
+                : downstream_(std::move(downstream)), codec_(c), level_(level), max_pending_(2 * std::max(1u, threads))
+            {
+                for (unsigned int i = 0; i < std::max(1u, threads); ++i) workers_.emplace_back([this] { work(); });
+            }
+            parallel_compressor(const parallel_compressor &) = delete;
+            parallel_compressor &operator=(const parallel_compressor &) = delete;
+            ~parallel_compressor()
+            {
+                try { finish(); } catch (...) {}
+            }
+
+            // Queue a block for compression. Thread-safe. Rethrows a compression or
+            // downstream error from an earlier block.
+            void write(const std::string_view block)
+            {
+                std::unique_lock lock(mutex_);
+                space_.wait(lock, [this] { return std::size(queue_) + std::size(done_) < max_pending_ || error_; });
+                if (error_) std::rethrow_exception(error_);
+                if (finished_) throw std::logic_error("write after finish");
+                queue_.emplace(next_seq_++, std::string(block));
+                work_.notify_one();
+            }
+
+            block_sink_type sink()
+            {
+                return [this](const std::string_view block) { write(block); };
+            }
+
+            // Wait until every block has been written downstream and stop the workers.
+            void finish()
+            {
+                {
+                    std::lock_guard lock(mutex_);
+                    if (finished_ && workers_.empty()) return;
+                    finished_ = true;
+                }
+                work_.notify_all();
+                for (auto &t : workers_) t.join();
+                workers_.clear();
+                if (error_) std::rethrow_exception(error_);
+            }
+
+            // Offsets of the frames written so far.
+            std::vector<frame_offset> frames() const
+            {
+                std::lock_guard lock(mutex_);
+                return frames_;
+            }
+
+        private:
+            void work()
+            {
+                std::string frame;
+                for (;;)
+                {
+                    std::uint64_t seq;
+                    std::string block;
+                    {
+                        std::unique_lock lock(mutex_);
+                        work_.wait(lock, [this] { return !queue_.empty() || finished_ || error_; });
+                        if (queue_.empty() || error_) return;
+                        seq = queue_.begin()->first;
+                        block = std::move(queue_.begin()->second);
+                        queue_.erase(queue_.begin());
+                        space_.notify_one();
+                    }
+                    try
+                    {
+                        frame.clear();
+                        compress_frame(codec_, level_, block, frame);
+                        std::unique_lock lock(mutex_);
+                        done_.emplace(seq, std::pair{std::size(block), std::move(frame)});
+                        frame = std::string();
+                        if (emitting_) continue;
+                        // Become the emitter and write out every frame that is due, outside the lock.
+                        emitting_ = true;
+                        for (auto it = done_.find(next_write_); it != done_.end(); it = done_.find(next_write_))
+                        {
+                            const auto raw_size = it->second.first;
+                            auto out = std::move(it->second.second);
+                            done_.erase(it);
+                            lock.unlock();
+                            downstream_(out);
+                            lock.lock();
+                            frames_.push_back({raw_offset_, compressed_offset_});
+                            raw_offset_ += raw_size;
+                            compressed_offset_ += std::size(out);
+                            ++next_write_;
+                            space_.notify_one();
+                        }
+                        emitting_ = false;
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard lock(mutex_);
+                        if (!error_) error_ = std::current_exception();
+                        emitting_ = false;
+                        space_.notify_all();
+                        work_.notify_all();
+                        return;
+                    }
+                }
+            }
+
+            block_sink_type downstream_;
+            codec codec_;
+            int level_;
+            std::size_t max_pending_;
+            std::vector<std::thread> workers_;
+
+            mutable std::mutex mutex_;
+            std::condition_variable work_, space_;
+            std::map<std::uint64_t, std::string> queue_;    // Blocks to compress by sequence number.
+            std::map<std::uint64_t, std::pair<std::size_t, std::string>> done_;  // Raw size and frame by sequence number.
+            std::uint64_t next_seq_ = 0, next_write_ = 0;
+            std::uint64_t raw_offset_ = 0, compressed_offset_ = 0;
+            std::vector<frame_offset> frames_;
+            bool emitting_ = false;     // Whether a worker is writing frames downstream.
+            bool finished_ = false;
+            std::exception_ptr error_;
+        };
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <any>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "permutation.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    namespace permutation5
+    {
+        // Heap's algorithm (permutation4) replaying a precomputed swap schedule.
+        // The swaps Heap's algorithm does below level m depend only on the positions, not
+        // on the elements, and restart from the same state after every swap at level m or
+        // above. So the m! - 1 swaps of the bottom m levels are generated once into a
+        // table and replayed with a sequential read per permutation; only the top n - m
+        // levels run the counters, once every m! permutations.
+
+        // The most levels a table covers; their positions fit in a nibble each.
+        constexpr unsigned int max_table_levels = 8;
+        // Levels covered by perm_all() and perm_range(): a 7! byte table fits in L1.
+        constexpr unsigned int default_table_levels = 7;
+
+        // One byte per swap: the higher position in the high nibble, the lower in the low.
+        using schedule_type = std::vector<std::uint8_t>;
+
+        // The swaps of Heap's algorithm on m elements, m <= max_table_levels.
+        inline schedule_type make_schedule(const unsigned int m)
+        {
+            if (m > max_table_levels) throw std::out_of_range("too many table levels");
+            schedule_type s;
+            s.reserve(permutation_rank::factorial(m));
+            std::vector<unsigned int> c(m, 0);
+            for (unsigned int i = 1; i < m;)
+            {
+                if (c[i] < i)
+                {
+                    const auto j = (i & 1) == 0 ? 0 : c[i];
+                    s.push_back(static_cast<std::uint8_t>(i << 4 | j));
+                    ++c[i];
+                    i = 1;
+                }
+                else
+                {
+                    c[i] = 0;
+                    ++i;
+                }
+            }
+            return s;
+        }
+
+        // The schedule for m levels, built on first use and shared by all threads.
+        inline const schedule_type &schedule(const unsigned int m)
+        {
+            static const auto tables = [] {
+                std::array<schedule_type, max_table_levels + 1> r;
+                for (unsigned int k = 0; k <= max_table_levels; ++k) r[k] = make_schedule(k);
+                return r;
+            }();
+            if (m > max_table_levels) throw std::out_of_range("too many table levels");
+            return tables[m];
+        }
+
+        namespace detail
+        {
+            // Visit a and the following permutations until the last or until count have been
+            // visited. pos is the next swap of the table of the bottom m levels and c[m:n)
+            // the counters of the levels above.
+            template <std::random_access_iterator TIter, typename TVisit>
+            inline void replay(const TIter first, const TIter last, const unsigned int m, std::vector<int> &c,
+                std::size_t pos, std::uint64_t count, TVisit &visit)
+            {
+                const auto n = static_cast<int>(std::distance(first, last));
+                const auto &s = schedule(m);
+                const auto *table = std::data(s);
+                const auto size = std::size(s);
+                visit(first, last);
+                while (--count > 0)
+                {
+                    if (pos < size)
+                    {
+                        const auto ij = table[pos++];
+                        std::iter_swap(first + (ij >> 4), first + (ij & 15));
+                    }
+                    else
+                    {
+                        auto i = static_cast<int>(m);
+                        while (i < n && c[i] >= i) c[i++] = 0;
+                        if (i >= n) return;
+                        std::iter_swap(first + ((i & 1) == 0 ? 0 : c[i]), first + i);
+                        ++c[i];
+                        pos = 0;
+                    }
+                    visit(first, last);
+                }
+            }
+        }
+
+        // Rearrange [first:last) into every permutation in the order of permutation4 and call
+        // visit(first, last) for each, replaying a table for up to levels bottom levels.
+        template <std::random_access_iterator TIter, typename TVisit>
+        inline void perm_each(const TIter first, const TIter last, TVisit visit, const unsigned int levels = default_table_levels)
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            const auto m = std::min(n, levels);
+            std::vector<int> c(n, 0);
+            detail::replay(first, last, m, c, 0, std::numeric_limits<std::uint64_t>::max(), visit);
+        }
+
+        // [first:last): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm_all(const TIter first, const TIter last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            perm_type a{first, last};
+            perm_each(std::begin(a), std::end(a), [&](const auto f, const auto l) { output_each_perm(f, l, user_data); });
+        }
+
+        // Permutations of rank [rank_first:rank_last) in the order perm_all() generates them.
+        // [first:last): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm_range(const TIter first, const TIter last, const rank_type rank_first, const rank_type rank_last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            if (rank_first >= rank_last) return;
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            if (rank_last > permutation_rank::factorial(n)) throw std::out_of_range("rank out of range");
+            perm_type a{first, last};
+            permutation_rank::unrank_heap(std::begin(a), std::end(a), rank_first);
+            auto c = permutation_rank::heap_counters(n, rank_first);
+            // The bottom counters are the low factorial digits of the rank, so the table
+            // position is the rank modulo m!.
+            const auto m = std::min(n, default_table_levels);
+            auto visit = [&](const auto f, const auto l) { output_each_perm(f, l, user_data); };
+            detail::replay(std::begin(a), std::end(a), m, c, rank_first % permutation_rank::factorial(m), rank_last - rank_first, visit);
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "boost/iterator/permutation_iterator.hpp"
+#include "permutation.h"
+#include "permutation_registry.h"
+
+namespace permutation_algorithms
+{
+    // Permutations of objects of any type, large or move-only ones included. The engines
+    // permute handles, the indices of the objects, so a step swaps two 32-bit values
+    // whatever the size of the objects; the objects are read through a view, and copied
+    // or moved into that order only on demand.
+    namespace indirect
+    {
+        using handle_type = std::uint32_t;
+        using handles_type = std::vector<handle_type>;
+
+        namespace detail
+        {
+            inline handles_type identity(const std::size_t n)
+            {
+                if (n > std::numeric_limits<handle_type>::max()) throw std::domain_error("too many elements");
+                handles_type h(n);
+                std::iota(std::begin(h), std::end(h), 0);
+                return h;
+            }
+        }
+
+        // Call visit(handles) for every permutation of the handles 0 ... n-1 in the order of
+        // permutation4 (Heap's algorithm), stepped by permutation4's own loop.
+        template <typename TVisit>
+        inline void heap(const std::size_t n, TVisit visit)
+        {
+            auto h = detail::identity(n);
+            if (n == 0) return;
+            permutation4::perm_each(std::begin(h), std::end(h), [&](auto, auto) { visit(std::as_const(h)); });
+        }
+
+        // In lexicographic order of the handles, i.e. of the objects' positions.
+        template <typename TVisit>
+        inline void lexicographic(const std::size_t n, TVisit visit)
+        {
+            auto h = detail::identity(n);
+            if (n == 0) return;
+            permutation_std::perm_each(std::begin(h), std::end(h), [&](auto, auto) { visit(std::as_const(h)); });
+        }
+
+        // In the order of permutation2 (plain changes).
+        template <typename TVisit>
+        inline void plain_changes(const std::size_t n, TVisit visit)
+        {
+            auto h = detail::identity(n);
+            permutation2::perm_each(std::begin(h), std::end(h), [&](auto, auto) { visit(std::as_const(h)); });
+        }
+
+        // The objects in the order of handles, without copying them.
+        template <typename T>
+        class perm_view
+        {
+        public:
+            using iterator = boost::permutation_iterator<typename std::span<const T>::iterator, handles_type::const_iterator>;
+
+            perm_view(const std::span<const T> objects, const handles_type &handles) : objects_(objects), handles_(handles) {}
+
+            std::size_t size() const { return std::size(handles_); }
+            const T &operator[](const std::size_t i) const { return objects_[handles_[i]]; }
+            iterator begin() const { return boost::make_permutation_iterator(std::begin(objects_), std::cbegin(handles_)); }
+            iterator end() const { return boost::make_permutation_iterator(std::begin(objects_), std::cend(handles_)); }
+            const handles_type &handles() const { return handles_; }
+
+            // Copy the objects into dest in this order.
+            void materialize(std::vector<T> &dest) const { dest.assign(begin(), end()); }
+
+        private:
+            std::span<const T> objects_;
+            const handles_type &handles_;
+        };
+
+        // Rearrange objects so that objects[i] becomes the former objects[handles[i]],
+        // moving each object once along the cycles of the permutation; no copies.
+        template <typename T>
+        inline void apply(std::vector<T> &objects, handles_type handles)
+        {
+            if (std::size(handles) != std::size(objects)) throw std::invalid_argument("handles and objects differ in size");
+            for (std::size_t start = 0; start < std::size(handles); ++start)
+            {
+                if (handles[start] == start) continue;
+                auto held = std::move(objects[start]);
+                auto j = start;
+                for (;;)
+                {
+                    const std::size_t k = handles[j];
+                    handles[j] = static_cast<handle_type>(j);   // done
+                    if (k == start)
+                    {
+                        objects[j] = std::move(held);
+                        break;
+                    }
+                    objects[j] = std::move(objects[k]);
+                    j = k;
+                }
+            }
+        }
+
+        // Call visit(perm_view<T>) for every permutation of objects in order, one of the
+        // orders above. Throws std::domain_error for an order without a handle engine.
+        template <typename T, typename TVisit>
+        inline void perm_all(const std::span<const T> objects, const registry::perm_order order, TVisit visit)
+        {
+            auto to_view = [&](const handles_type &h) { visit(perm_view<T>(objects, h)); };
+            switch (order)
+            {
+            case registry::perm_order::heap: heap(std::size(objects), to_view); return;
+            case registry::perm_order::lexicographic: lexicographic(std::size(objects), to_view); return;
+            case registry::perm_order::plain_changes: plain_changes(std::size(objects), to_view); return;
+            default: break;
+            }
+            throw std::domain_error("no handle engine for " + std::string(registry::to_string(order)) + " order");
+        }
+    }
+}
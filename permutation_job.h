@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "permutation.h"
+#include "permutation_autotune.h"
+#include "permutation_output.h"
+#include "permutation_registry.h"
+
+namespace permutation_algorithms
+{
+    // Split line at blanks into elems, which refer into line.
+    inline void split_elements(const std::string_view line, perm_type &elems)
+    {
+        constexpr std::string_view blanks = " \t\r\n";
+        elems.clear();
+        for (auto pos = line.find_first_not_of(blanks); pos != std::string_view::npos; )
+        {
+            const auto end = std::min(line.find_first_of(blanks, pos), std::size(line));
+            elems.emplace_back(line.substr(pos, end - pos));
+            pos = line.find_first_not_of(blanks, end);
+        }
+    }
+
+    // Runs many small enumerations one after another, resolving the engine once per
+    // number of elements and writing every job to the same output buffer.
+    class job_runner
+    {
+    public:
+        // algorithm: an engine name or "auto".
+        // order: the order required by "auto".
+        // prof: the autotune profile consulted by "auto", or nullptr.
+        // out: where permutations are printed, or nullptr to count only.
+        job_runner(std::string algorithm, std::optional<registry::perm_order> order, const autotune::profile *prof, output_buffer *out)
+            : algorithm_(std::move(algorithm)), order_(order), profile_(prof), out_(out)
+        {
+            if (algorithm_ != "auto") engine_ = &registry::get_engine(algorithm_);
+        }
+
+        // Return the engine jobs of n elements run with.
+        const registry::engine &engine_for(const std::size_t n)
+        {
+            if (engine_) return *engine_;
+            if (n >= std::size(engines_by_n_)) engines_by_n_.resize(n + 1, nullptr);
+            auto &e = engines_by_n_[n];
+            if (!e)
+            {
+                registry::requirements req;
+                req.n = n;
+                req.order = order_;
+                const auto mode = out_ ? autotune::mode_print : autotune::mode_count;
+                // Jobs run sequentially, so only sequential profile entries apply.
+                if (const auto c = profile_ ? autotune::choose(*profile_, mode, req) : std::nullopt; c && c->threads == 1) e = c->engine;
+                else e = &registry::select_engine(req);
+            }
+            return *e;
+        }
+
+        // Enumerate the permutations of elems; return their number.
+        int64_t run(const perm_type &elems)
+        {
+            count_ = 0;
+            engine_for(std::size(elems)).perm_all(std::cbegin(elems), std::cend(elems), each_perm, this);
+            return count_;
+        }
+
+    private:
+        static void each_perm(const perm_iterator_type first, const perm_iterator_type last, const std::any &user_data)
+        {
+            auto self = std::any_cast<job_runner *>(user_data);
+            ++self->count_;
+            if (self->out_) self->out_->append(first, last);
+        }
+
+        std::string algorithm_;
+        std::optional<registry::perm_order> order_;
+        const autotune::profile *profile_;
+        output_buffer *out_;
+        const registry::engine *engine_ = nullptr;
+        std::vector<const registry::engine *> engines_by_n_;
+        int64_t count_ = 0;
+    };
+}
@@ -0,0 +1,313 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "boost/multiprecision/cpp_int.hpp"
+
+namespace permutation_algorithms
+{
+    namespace lehmer
+    {
+        // Step counts and ranks beyond rank_type, for n in the hundreds.
+        using rank128_type = unsigned __int128;
+        using big_rank_type = boost::multiprecision::cpp_int;
+
+        // Counts over positions [0:n) with O(log n) update, prefix sum and k-th search.
+        class fenwick_tree
+        {
+        public:
+            explicit fenwick_tree(const std::size_t n) : tree_(n + 1, 0) {}
+
+            // A tree with count 1 at each position where present[i] holds, built in O(n).
+            template <typename TPred>
+            fenwick_tree(const std::size_t n, TPred present) : tree_(n + 1, 0)
+            {
+                for (std::size_t i = 1; i <= n; ++i)
+                {
+                    tree_[i] += present(i - 1) ? 1 : 0;
+                    if (const auto parent = i + (i & -i); parent <= n) tree_[parent] += tree_[i];
+                }
+            }
+
+            void add(std::size_t i, const std::ptrdiff_t delta)
+            {
+                for (++i; i < std::size(tree_); i += i & -i) tree_[i] += delta;
+            }
+
+            // Sum of the counts at positions [0:i).
+            std::ptrdiff_t prefix_sum(std::size_t i) const
+            {
+                std::ptrdiff_t r = 0;
+                for (; i > 0; i -= i & -i) r += tree_[i];
+                return r;
+            }
+
+            // The position p such that prefix_sum(p) == k and the count at p is positive,
+            // i.e. the k-th (0-based) present position. Counts must be 0 or 1.
+            std::size_t find_kth(std::ptrdiff_t k) const
+            {
+                std::size_t pos = 0;
+                std::size_t step = 1;
+                while (step * 2 < std::size(tree_)) step *= 2;
+                for (; step > 0; step /= 2)
+                {
+                    if (pos + step < std::size(tree_) && tree_[pos + step] <= k)
+                    {
+                        pos += step;
+                        k -= tree_[pos];
+                    }
+                }
+                return pos;
+            }
+
+        private:
+            std::vector<std::ptrdiff_t> tree_;
+        };
+
+        namespace detail
+        {
+            // The elements of [first:last) sorted, and the index in that order of each element.
+            template <std::random_access_iterator TIter>
+            inline auto value_indices(const TIter first, const TIter last)
+            {
+                using value_type = std::iter_value_t<TIter>;
+                const auto n = static_cast<std::size_t>(std::distance(first, last));
+                std::vector<value_type> sorted(first, last);
+                std::sort(std::begin(sorted), std::end(sorted));
+                std::vector<std::size_t> index(n);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    index[i] = static_cast<std::size_t>(std::lower_bound(std::cbegin(sorted), std::cend(sorted), first[i]) - std::cbegin(sorted));
+                }
+                return std::pair(std::move(sorted), std::move(index));
+            }
+
+            // Digit i of the Lehmer code: the number of later elements with a smaller index.
+            inline std::vector<std::size_t> code_of_indices(const std::vector<std::size_t> &index)
+            {
+                const auto n = std::size(index);
+                std::vector<std::size_t> code(n);
+                fenwick_tree later(n);
+                for (auto i = n; i-- > 0; )
+                {
+                    code[i] = static_cast<std::size_t>(later.prefix_sum(index[i]));
+                    later.add(index[i], 1);
+                }
+                return code;
+            }
+
+            // Write to first[from:n) the elements of sorted with indices in index[from:n),
+            // ordered by code[from:n).
+            template <std::random_access_iterator TIter, typename TValue>
+            inline void place_suffix(const TIter first, const std::vector<TValue> &sorted, const std::vector<std::size_t> &index,
+                const std::vector<std::size_t> &code, const std::size_t from)
+            {
+                const auto n = std::size(index);
+                std::vector<bool> in_suffix(n, false);
+                for (auto i = from; i < n; ++i) in_suffix[index[i]] = true;
+                fenwick_tree free(n, [&](const std::size_t v) { return in_suffix[v]; });
+                for (auto i = from; i < n; ++i)
+                {
+                    const auto v = free.find_kth(static_cast<std::ptrdiff_t>(code[i]));
+                    first[i] = sorted[v];
+                    free.add(v, -1);
+                }
+            }
+
+            template <typename TStep>
+            inline std::size_t divmod(TStep &step, const std::size_t radix)
+            {
+                const auto r = static_cast<std::size_t>(step % radix);
+                step /= radix;
+                return r;
+            }
+
+            // Product of the integers [lo:hi), by halves so that the operands stay balanced.
+            inline big_rank_type product(const std::size_t lo, const std::size_t hi)
+            {
+                if (hi - lo <= 8)
+                {
+                    big_rank_type r = 1;
+                    for (auto k = lo; k < hi; ++k) r *= k;
+                    return r;
+                }
+                const auto mid = lo + (hi - lo) / 2;
+                return product(lo, mid) * product(mid, hi);
+            }
+
+            // In the recursions below, digit i of d[lo:hi) has radix base + hi - i and weight
+            // the product of the radices of the digits after it. With base 0 these are the
+            // factorial digits of a Lehmer code. Splitting at mid, the low digits [mid:hi)
+            // span the radix product (base + hi - mid)! / base!, and the high digits are
+            // the same kind of number with base + hi - mid as their base. Both halves are
+            // converted separately, so multiplication and division act on balanced operands
+            // instead of on one big number per digit.
+            constexpr std::size_t small_digits = 8;
+
+            inline big_rank_type from_digits(const std::vector<std::size_t> &d, const std::size_t lo, const std::size_t hi, const std::size_t base)
+            {
+                if (hi - lo <= small_digits)
+                {
+                    big_rank_type r = 0;
+                    for (auto i = lo; i < hi; ++i) r = r * (base + hi - i) + d[i];
+                    return r;
+                }
+                const auto mid = lo + (hi - lo) / 2;
+                return from_digits(d, lo, mid, base + hi - mid) * product(base + 1, base + hi - mid + 1) + from_digits(d, mid, hi, base);
+            }
+
+            inline void to_digits(big_rank_type v, std::vector<std::size_t> &d, const std::size_t lo, const std::size_t hi, const std::size_t base)
+            {
+                if (hi - lo <= small_digits)
+                {
+                    for (auto i = hi; i-- > lo; ) d[i] = divmod(v, base + hi - i);
+                    return;
+                }
+                const auto mid = lo + (hi - lo) / 2;
+                big_rank_type q, r;
+                boost::multiprecision::divide_qr(v, product(base + 1, base + hi - mid + 1), q, r);
+                to_digits(std::move(r), d, mid, hi, base);
+                to_digits(std::move(q), d, lo, mid, base + hi - mid);
+            }
+
+            // Add (subtract if negate) step to the rank of the permutation [first:last) of
+            // distinct elements in lexicographic order. Digit i of its Lehmer code is the
+            // factorial digit of radix n - i. Only the suffix whose digits change is rebuilt.
+            // A big_rank_type step is split into factorial digits by to_digits(); a machine
+            // word has at most a few dozen nonzero digits, divided off one by one.
+            template <std::random_access_iterator TIter, typename TStep>
+            inline bool step_lex(const TIter first, const TIter last, TStep step, const bool negate)
+            {
+                const auto n = static_cast<std::size_t>(std::distance(first, last));
+                // Every nonzero step wraps around the single permutation.
+                if (n < 2 || step == 0) return step == 0;
+
+                std::vector<std::size_t> digit(n, 0);
+                bool wraps;
+                if constexpr (std::is_same_v<TStep, big_rank_type>)
+                {
+                    big_rank_type q, r;
+                    boost::multiprecision::divide_qr(step, product(1, n + 1), q, r);
+                    to_digits(std::move(r), digit, 0, n, 0);
+                    wraps = q != 0;
+                }
+                else
+                {
+                    for (auto i = n; i-- > 0 && step != 0; ) digit[i] = divmod(step, n - i);
+                    wraps = step != 0;
+                }
+                const auto top = static_cast<std::size_t>(std::find_if(std::cbegin(digit), std::cend(digit), [](const std::size_t d) { return d != 0; }) - std::cbegin(digit));
+                if (top == n) return !wraps;
+
+                const auto [sorted, index] = value_indices(first, last);
+                auto code = code_of_indices(index);
+
+                // Add or subtract in the factorial number system from the last digit.
+                auto changed = n;
+                std::size_t carry = 0;
+                for (auto i = n; i-- > 0 && (i >= top || carry != 0); )
+                {
+                    const auto radix = n - i;
+                    const auto r = digit[i] + carry;
+                    carry = 0;
+                    if (r == 0) continue;
+                    if (!negate)
+                    {
+                        // code[i] + r may reach radix; carry one.
+                        code[i] += r;
+                        if (code[i] >= radix)
+                        {
+                            code[i] -= radix;
+                            carry = 1;
+                        }
+                    }
+                    else
+                    {
+                        if (code[i] < r)
+                        {
+                            code[i] += radix - r;
+                            carry = 1;
+                        }
+                        else code[i] -= r;
+                    }
+                    changed = i;
+                }
+                if (changed < n) place_suffix(first, sorted, index, code, changed);
+                return !wraps && carry == 0;
+            }
+        }
+
+        // Return n!.
+        inline big_rank_type factorial(const std::size_t n)
+        {
+            return detail::product(1, n + 1);
+        }
+
+        // Return the Lehmer code of the permutation [first:last) of distinct elements:
+        // digit i is the number of later elements less than element i. O(n log n).
+        template <std::random_access_iterator TIter>
+        inline std::vector<std::size_t> lehmer_code(const TIter first, const TIter last)
+        {
+            return detail::code_of_indices(detail::value_indices(first, last).second);
+        }
+
+        // Return the lexicographic rank whose factorial digits are the Lehmer code.
+        inline big_rank_type code_to_rank(const std::vector<std::size_t> &code)
+        {
+            return detail::from_digits(code, 0, std::size(code), 0);
+        }
+
+        // Return the Lehmer code of n digits of rank r. Throws std::out_of_range if r >= n!.
+        inline std::vector<std::size_t> rank_to_code(const big_rank_type &r, const std::size_t n)
+        {
+            if (r < 0 || r >= factorial(n)) throw std::out_of_range("rank out of range");
+            std::vector<std::size_t> code(n);
+            detail::to_digits(r, code, 0, n, 0);
+            return code;
+        }
+
+        // Return the rank in lexicographic order of the permutation [first:last) of
+        // distinct elements, for any n.
+        template <std::random_access_iterator TIter>
+        inline big_rank_type rank_lex(const TIter first, const TIter last)
+        {
+            return code_to_rank(lehmer_code(first, last));
+        }
+
+        // Rearrange [first:last), which must have distinct elements, into the permutation
+        // of rank r in lexicographic order, for any n. Throws std::out_of_range if r >= n!.
+        template <std::random_access_iterator TIter>
+        inline void unrank_lex(const TIter first, const TIter last, const big_rank_type &r)
+        {
+            const auto code = rank_to_code(r, static_cast<std::size_t>(std::distance(first, last)));
+            const auto [sorted, index] = detail::value_indices(first, last);
+            detail::place_suffix(first, sorted, index, code, 0);
+        }
+
+        // Move the permutation [first:last) of distinct elements step places forward in
+        // lexicographic order, wrapping around after the last permutation. O(n log n) for
+        // a machine word step; a big_rank_type step also costs its conversion to factorial
+        // digits, as rank_to_code().
+        // Returns false if it wrapped, as std::next_permutation does.
+        // TStep is an unsigned integer type, rank128_type or big_rank_type.
+        template <std::random_access_iterator TIter, typename TStep>
+        inline bool advance(const TIter first, const TIter last, const TStep &step)
+        {
+            return detail::step_lex(first, last, step, false);
+        }
+
+        // Move the permutation step places backward; returns false if it wrapped,
+        // as std::prev_permutation does.
+        template <std::random_access_iterator TIter, typename TStep>
+        inline bool retreat(const TIter first, const TIter last, const TStep &step)
+        {
+            return detail::step_lex(first, last, step, true);
+        }
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "permutation.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    // Containers of a value per permutation of a fixed set of distinct elements, indexed
+    // by the lexicographic rank of the permutation: a lookup ranks the permutation in O(n)
+    // and reads an array, instead of hashing a vector of string_views.
+    namespace perm_index
+    {
+        // Ranks permutations of the elements it is constructed with.
+        class indexer
+        {
+        public:
+            // [first:last): The elements, at most permutation_rank::max_rank_n of them.
+            // Throws std::invalid_argument if they are not distinct.
+            indexer(const perm_iterator_type first, const perm_iterator_type last) : elems_(first, last)
+            {
+                if (std::size(elems_) > permutation_rank::max_rank_n) throw std::invalid_argument("too many elements to rank");
+                std::sort(std::begin(elems_), std::end(elems_));
+                if (std::adjacent_find(std::cbegin(elems_), std::cend(elems_)) != std::cend(elems_)) throw std::invalid_argument("elements are not distinct");
+            }
+
+            std::size_t n() const { return std::size(elems_); }
+            // The number of permutations, n!.
+            rank_type size() const { return permutation_rank::factorial(static_cast<unsigned int>(n())); }
+            // The elements in sorted order; index i of a permutation of indices is elements()[i].
+            const perm_type &elements() const { return elems_; }
+
+            // The lexicographic rank of a permutation of the indices 0 ... n-1. O(n): the
+            // digit of each index is the number of smaller indices not yet used, a popcount.
+            // Throws std::invalid_argument if it is not a permutation.
+            rank_type rank(const std::span<const std::uint8_t> indices) const
+            {
+                if (std::size(indices) != n()) throw std::invalid_argument("permutation of another size");
+                std::uint32_t used = 0;
+                rank_type r = 0;
+                for (std::size_t i = 0; i < std::size(indices); ++i)
+                {
+                    if (indices[i] >= n()) throw std::invalid_argument("not a permutation");
+                    const auto bit = std::uint32_t{1} << indices[i];
+                    if (used & bit) throw std::invalid_argument("not a permutation");
+                    r = r * (n() - i) + (indices[i] - std::popcount(used & (bit - 1)));
+                    used |= bit;
+                }
+                return r;
+            }
+
+            // The rank of a permutation of the elements, found by binary search.
+            rank_type rank(const perm_iterator_type first, const perm_iterator_type last) const
+            {
+                std::uint8_t indices[permutation_rank::max_rank_n];
+                const auto size = static_cast<std::size_t>(std::distance(first, last));
+                if (size != n()) throw std::invalid_argument("permutation of another size");
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    const auto it = std::lower_bound(std::cbegin(elems_), std::cend(elems_), first[i]);
+                    if (it == std::cend(elems_) || *it != first[i]) throw std::invalid_argument("not a permutation");
+                    indices[i] = static_cast<std::uint8_t>(it - std::cbegin(elems_));
+                }
+                return rank({indices, size});
+            }
+
+            // The permutation of rank r. Throws std::out_of_range if r >= size().
+            perm_type unrank(const rank_type r) const
+            {
+                auto p = elems_;
+                permutation_rank::unrank_lex(std::begin(p), std::end(p), r);
+                return p;
+            }
+
+        private:
+            perm_type elems_;
+        };
+
+        // A T for each of the n! permutations of up to max_dense_n elements, in one array.
+        template <typename T>
+        class perm_map
+        {
+        public:
+            // 12! values of one byte take 479 MB.
+            static constexpr std::size_t max_dense_n = 12;
+
+            // Throws std::length_error for more than max_dense_n elements.
+            perm_map(const perm_iterator_type first, const perm_iterator_type last, const T &init = T{})
+                : indexer_(checked(first, last)), values_(std::make_unique<T[]>(indexer_.size()))
+            {
+                std::fill_n(values_.get(), indexer_.size(), init);
+            }
+
+            T &operator[](const rank_type r) { return values_[r]; }
+            const T &operator[](const rank_type r) const { return values_[r]; }
+            T &at(const perm_iterator_type first, const perm_iterator_type last) { return values_[indexer_.rank(first, last)]; }
+            const T &at(const perm_iterator_type first, const perm_iterator_type last) const { return values_[indexer_.rank(first, last)]; }
+
+            rank_type size() const { return indexer_.size(); }
+            T *data() { return values_.get(); }
+            const T *data() const { return values_.get(); }
+            const indexer &index() const { return indexer_; }
+
+        private:
+            static indexer checked(const perm_iterator_type first, const perm_iterator_type last)
+            {
+                if (static_cast<std::size_t>(std::distance(first, last)) > max_dense_n) throw std::length_error("too many elements for a dense perm_map");
+                return indexer(first, last);
+            }
+
+            indexer indexer_;
+            std::unique_ptr<T[]> values_;
+        };
+
+        // A T for each permutation of up to permutation_rank::max_rank_n elements, in pages
+        // of PageSize consecutive ranks allocated on first write. The pages are found by
+        // hashing the rank divided by PageSize, one integer per lookup; absent values are T{}.
+        template <typename T, std::size_t PageSize = 4096>
+        class sparse_perm_map
+        {
+        public:
+            sparse_perm_map(const perm_iterator_type first, const perm_iterator_type last) : indexer_(first, last) {}
+
+            // The value of rank r, allocating its page.
+            T &operator[](const rank_type r)
+            {
+                if (r >= indexer_.size()) throw std::out_of_range("rank out of range");
+                auto &page = pages_[r / PageSize];
+                if (!page) page = std::make_unique<T[]>(PageSize);
+                return page[r % PageSize];
+            }
+            T &at(const perm_iterator_type first, const perm_iterator_type last) { return (*this)[indexer_.rank(first, last)]; }
+
+            // The value of rank r, without allocating.
+            T get(const rank_type r) const
+            {
+                const auto it = pages_.find(r / PageSize);
+                return it == std::cend(pages_) ? T{} : it->second[r % PageSize];
+            }
+            T get(const perm_iterator_type first, const perm_iterator_type last) const { return get(indexer_.rank(first, last)); }
+
+            // Pages allocated so far.
+            std::size_t pages() const { return std::size(pages_); }
+            const indexer &index() const { return indexer_; }
+
+        private:
+            indexer indexer_;
+            std::unordered_map<rank_type, std::unique_ptr<T[]>> pages_;
+        };
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "permutation.h"
+
+namespace permutation_algorithms
+{
+    // Rows and columns of a square matrix reordered by every permutation, as in assignment
+    // and tour problems: the view of p is M[p[i]][p[j]]. Gathering it costs n^2 reads per
+    // permutation; in an adjacent transposition order the next view is the previous one
+    // with two rows and two columns exchanged, 4n element moves in place.
+    namespace matrix
+    {
+        using index_type = std::uint32_t;
+
+        // view[i][j] = m[p[i]][p[j]]; m and view are n by n, row major.
+        template <typename T>
+        inline void gather(const std::span<const T> m, const std::size_t n, const std::span<const index_type> p, const std::span<T> view)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                const auto *src = std::data(m) + p[i] * n;
+                auto *dst = std::data(view) + i * n;
+                for (std::size_t j = 0; j < n; ++j) dst[j] = src[p[j]];
+            }
+        }
+
+        // The view of a matrix under a permutation kept materialized and updated by swaps,
+        // starting from the identity.
+        template <typename T>
+        class permuted_matrix
+        {
+        public:
+            // m: n by n, row major. Throws std::invalid_argument if its size is not n * n.
+            permuted_matrix(const std::span<const T> m, const std::size_t n) : view_(std::cbegin(m), std::cend(m)), perm_(n), n_(n)
+            {
+                if (std::size(m) != n * n) throw std::invalid_argument("matrix is not n by n");
+                std::iota(std::begin(perm_), std::end(perm_), index_type{0});
+            }
+
+            // Exchange positions i and i + 1: two adjacent rows, then a pair of neighbours
+            // in every row, which share a cache line.
+            void swap_adjacent(const std::size_t i)
+            {
+                auto *a = std::data(view_);
+                std::swap_ranges(a + i * n_, a + (i + 1) * n_, a + (i + 1) * n_);
+                for (std::size_t r = 0; r < n_; ++r, a += n_) std::swap(a[i], a[i + 1]);
+                std::swap(perm_[i], perm_[i + 1]);
+            }
+
+            // Exchange positions i and j.
+            void swap(const std::size_t i, const std::size_t j)
+            {
+                if (i == j) return;
+                auto *a = std::data(view_);
+                std::swap_ranges(a + i * n_, a + (i + 1) * n_, a + j * n_);
+                for (std::size_t r = 0; r < n_; ++r, a += n_) std::swap(a[i], a[j]);
+                std::swap(perm_[i], perm_[j]);
+            }
+
+            std::size_t n() const { return n_; }
+            const T &operator()(const std::size_t i, const std::size_t j) const { return view_[i * n_ + j]; }
+            std::span<const T> row(const std::size_t i) const { return {std::data(view_) + i * n_, n_}; }
+            std::span<const T> data() const { return view_; }
+            // perm()[i]: the row and column of the matrix at position i of the view.
+            std::span<const index_type> perm() const { return perm_; }
+
+        private:
+            std::vector<T> view_;
+            std::vector<index_type> perm_;
+            std::size_t n_;
+        };
+
+        // Call visit(view) for the n! views of m, in plain changes order (the order of
+        // permutation2::perm_all), updating one view in place by adjacent swaps.
+        template <typename T, typename TVisit>
+        inline void for_each_permuted(const std::span<const T> m, const std::size_t n, TVisit visit)
+        {
+            if (n > static_cast<std::size_t>(std::numeric_limits<int>::max())) throw std::domain_error("too many elements");
+            permuted_matrix<T> view(m, n);
+            if (n == 0) return;
+            visit(std::as_const(view));
+            permutation2::perm_adjacent_swaps(static_cast<int>(n), [&](const int i)
+            {
+                view.swap_adjacent(static_cast<std::size_t>(i));
+                visit(std::as_const(view));
+            });
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "permutation.h"
+
+namespace permutation_algorithms
+{
+    // Distances between index permutations, i.e. orderings of the items 0 ... n-1
+    // given as the sequence of items. Both arguments must be permutations of the same n.
+    namespace metrics
+    {
+        using index_type = std::uint32_t;
+        using index_perm_type = std::vector<index_type>;
+
+        // Position of each item in p.
+        inline index_perm_type inverse(const std::span<const index_type> p)
+        {
+            index_perm_type r(std::size(p));
+            for (index_type i = 0; i < std::size(p); ++i) r[p[i]] = i;
+            return r;
+        }
+
+        namespace detail
+        {
+            inline void check_sizes(const std::span<const index_type> p, const std::span<const index_type> q)
+            {
+                if (std::size(p) != std::size(q)) throw std::invalid_argument("permutations of different sizes");
+            }
+
+            // For each position of p, the position of its item in q: the identity iff p == q.
+            inline index_perm_type relative(const std::span<const index_type> p, const std::span<const index_type> q)
+            {
+                check_sizes(p, q);
+                const auto pos_q = inverse(q);
+                index_perm_type r(std::size(p));
+                for (std::size_t i = 0; i < std::size(p); ++i) r[i] = pos_q[p[i]];
+                return r;
+            }
+
+            // Sort a and return its number of inversions, by bottom-up merge sort.
+            inline std::uint64_t sort_count_inversions(index_perm_type &a)
+            {
+                const auto n = std::size(a);
+                index_perm_type buf(n);
+                std::uint64_t inversions = 0;
+                for (std::size_t width = 1; width < n; width *= 2)
+                {
+                    for (std::size_t lo = 0; lo < n; lo += 2 * width)
+                    {
+                        const auto mid = std::min(lo + width, n), hi = std::min(lo + 2 * width, n);
+                        auto i = lo, j = mid, k = lo;
+                        while (i < mid && j < hi)
+                        {
+                            if (a[j] < a[i])
+                            {
+                                // a[j] precedes all of a[i:mid).
+                                inversions += mid - i;
+                                buf[k++] = a[j++];
+                            }
+                            else buf[k++] = a[i++];
+                        }
+                        k = std::copy(std::begin(a) + i, std::begin(a) + mid, std::begin(buf) + k) - std::begin(buf);
+                        std::copy(std::begin(a) + j, std::begin(a) + hi, std::begin(buf) + k);
+                    }
+                    a.swap(buf);
+                }
+                return inversions;
+            }
+        }
+
+        // Kendall tau distance: the number of pairs of items p and q order differently,
+        // the adjacent swaps needed to turn one into the other. O(n log n).
+        inline std::uint64_t kendall_tau(const std::span<const index_type> p, const std::span<const index_type> q)
+        {
+            auto r = detail::relative(p, q);
+            return detail::sort_count_inversions(r);
+        }
+
+        // Sum of |a[i] - b[i]| for a and b holding values less than their size, as rank
+        // vectors do. A branch-free loop over contiguous 32-bit values that compilers vectorize.
+        inline std::uint64_t l1_distance(const std::span<const index_type> a, const std::span<const index_type> b)
+        {
+            detail::check_sizes(a, b);
+            const auto n = std::size(a);
+            const auto *pa = std::data(a);
+            const auto *pb = std::data(b);
+            std::uint64_t sum = 0;
+            // 32-bit partial sums vectorize twice as wide; each term is below n, so flush
+            // them every 2^32 / n terms before they can overflow.
+            const auto block = std::max<std::size_t>(1, std::numeric_limits<std::uint32_t>::max() / std::max<std::size_t>(n, 1));
+            for (std::size_t lo = 0; lo < n; lo += block)
+            {
+                const auto hi = std::min(n, lo + block);
+                std::uint32_t part = 0;
+                for (auto i = lo; i < hi; ++i) part += std::max(pa[i], pb[i]) - std::min(pa[i], pb[i]);
+                sum += part;
+            }
+            return sum;
+        }
+
+        // Spearman footrule: the total displacement of the items between p and q.
+        inline std::uint64_t footrule(const std::span<const index_type> p, const std::span<const index_type> q)
+        {
+            detail::check_sizes(p, q);
+            return l1_distance(inverse(p), inverse(q));
+        }
+
+        // Cayley distance: the fewest swaps, adjacent or not, turning p into q;
+        // n minus the number of cycles of the relative permutation. O(n).
+        inline std::uint64_t cayley(const std::span<const index_type> p, const std::span<const index_type> q)
+        {
+            const auto r = detail::relative(p, q);
+            std::vector<bool> seen(std::size(r), false);
+            std::uint64_t cycles = 0;
+            for (std::size_t i = 0; i < std::size(r); ++i)
+            {
+                if (seen[i]) continue;
+                ++cycles;
+                for (auto j = i; !seen[j]; j = r[j]) seen[j] = true;
+            }
+            return std::size(r) - cycles;
+        }
+
+        // Ulam distance: the fewest moves of one item to another position turning p into
+        // q; n minus the longest common subsequence, i.e. the longest increasing
+        // subsequence of the relative permutation. O(n log n).
+        inline std::uint64_t ulam(const std::span<const index_type> p, const std::span<const index_type> q)
+        {
+            const auto r = detail::relative(p, q);
+            // tails[k]: the smallest last value of an increasing subsequence of length k + 1.
+            index_perm_type tails;
+            for (const auto v : r)
+            {
+                const auto it = std::lower_bound(std::begin(tails), std::end(tails), v);
+                if (it == std::end(tails)) tails.push_back(v);
+                else *it = v;
+            }
+            return std::size(r) - std::size(tails);
+        }
+
+        // Enumerate every permutation of the items 0 ... n-1, n = size of reference, in
+        // plain changes order (permutation2) and call visit(perm, distance) with the Kendall
+        // tau distance of each to reference. Each permutation differs from the previous one
+        // by an adjacent swap, which changes the distance by exactly one, so scoring costs
+        // O(1) per permutation after the first.
+        template <typename TVisit>
+        inline void kendall_tau_each(const std::span<const index_type> reference, TVisit visit)
+        {
+            index_perm_type perm(std::size(reference));
+            std::iota(std::begin(perm), std::end(perm), 0);
+            const auto pos_ref = inverse(reference);
+            auto distance = kendall_tau(perm, reference);
+            visit(static_cast<const index_perm_type &>(perm), distance);
+            permutation2::perm_adjacent_swaps(static_cast<int>(std::size(perm)), [&](const int i) {
+                // The swapped pair becomes discordant if reference had it in this order.
+                if (pos_ref[perm[i]] < pos_ref[perm[i + 1]]) ++distance;
+                else --distance;
+                std::swap(perm[i], perm[i + 1]);
+                visit(static_cast<const index_perm_type &>(perm), distance);
+            });
+        }
+    }
+}
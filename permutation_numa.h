@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include "permutation.h"
+#include "permutation_parallel.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    namespace numa
+    {
+        struct node
+        {
+            unsigned int id;
+            std::vector<int> cpus;      // CPUs of the node this process may run on.
+        };
+
+        // Parse a cpulist such as "0-3,8,10-11".
+        inline std::vector<int> parse_cpulist(const std::string &s)
+        {
+            std::vector<int> r;
+            std::istringstream is(s);
+            std::string part;
+            while (std::getline(is, part, ','))
+            {
+                if (part.find_first_not_of(" \n") == std::string::npos) continue;
+                const auto dash = part.find('-');
+                const auto lo = std::stoi(part.substr(0, dash));
+                const auto hi = dash == std::string::npos ? lo : std::stoi(part.substr(dash + 1));
+                for (auto c = lo; c <= hi; ++c) r.push_back(c);
+            }
+            return r;
+        }
+
+        // The NUMA nodes of this host from /sys/devices/system/node, restricted to the
+        // CPUs this process may run on. A host without that information is one node.
+        inline std::vector<node> topology()
+        {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            const bool have_affinity = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+            auto is_allowed = [&](const int cpu) { return !have_affinity || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)); };
+
+            std::vector<node> nodes;
+            std::error_code ec;
+            for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec))
+            {
+                const auto name = entry.path().filename().string();
+                if (name.rfind("node", 0) != 0 || name.find_first_not_of("0123456789", 4) != std::string::npos || std::size(name) == 4) continue;
+                std::ifstream is(entry.path() / "cpulist");
+                std::string list;
+                std::getline(is, list);
+                node nd{static_cast<unsigned int>(std::stoul(name.substr(4))), {}};
+                for (const auto cpu : parse_cpulist(list))
+                {
+                    if (is_allowed(cpu)) nd.cpus.push_back(cpu);
+                }
+                if (!nd.cpus.empty()) nodes.push_back(std::move(nd));
+            }
+            if (nodes.empty())
+            {
+                node nd{0, {}};
+                for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                {
+                    if (have_affinity && CPU_ISSET(cpu, &allowed)) nd.cpus.push_back(cpu);
+                }
+                if (nd.cpus.empty()) nd.cpus.push_back(-1);     // unknown; do not pin
+                nodes.push_back(std::move(nd));
+            }
+            std::sort(std::begin(nodes), std::end(nodes), [](const auto &a, const auto &b) { return a.id < b.id; });
+            return nodes;
+        }
+
+        // Where a worker thread runs.
+        struct worker
+        {
+            unsigned int index;
+            unsigned int node;          // Index into the topology, not the node id.
+            int cpu;                    // -1 if not pinned.
+        };
+
+        // Assign threads workers to CPUs, spreading them evenly over the nodes.
+        inline std::vector<worker> place_workers(const std::vector<node> &nodes, const unsigned int threads)
+        {
+            std::vector<worker> r;
+            for (unsigned int i = 0; i < threads; ++i)
+            {
+                const auto nd = i % static_cast<unsigned int>(std::size(nodes));
+                const auto &cpus = nodes[nd].cpus;
+                r.push_back({i, nd, cpus[(i / std::size(nodes)) % std::size(cpus)]});
+            }
+            return r;
+        }
+
+        struct node_report
+        {
+            unsigned int node_id;
+            unsigned int workers;
+            rank_type perms;
+            double seconds;             // The longest time a worker of the node ran.
+
+            double perms_per_second() const { return seconds > 0 ? perms / seconds : 0; }
+        };
+
+        // Called on each worker thread after it is pinned, before it generates anything;
+        // returns the user data output_each_perm receives on that thread. Memory allocated
+        // here is first touched by the worker, so it lands on the worker's node.
+        using init_worker_function_type = std::function<std::any(const worker &)>;
+
+        // Enumerate all permutations of [first:last) on threads workers pinned to CPUs
+        // spread over the NUMA nodes. Each node owns a contiguous part of the rank space
+        // in proportion to its workers and hands it out in chunks through its own counter,
+        // so workers of different nodes do not share cache lines; a worker whose node has
+        // run out takes chunks from other nodes.
+        // Returns the permutations generated and the time taken per node.
+        inline std::vector<node_report> perm_all(const perm_range_function_type &perm_range, const perm_iterator_type first, const perm_iterator_type last,
+            output_each_perm_function_type output_each_perm, const init_worker_function_type &init_worker, const unsigned int threads,
+            const std::vector<node> &nodes = topology())
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            const auto total = permutation_rank::factorial(n);
+            const auto workers = place_workers(nodes, std::max(1u, threads));
+
+            // Per-node share of the rank space and chunk counter, each on its own cache line.
+            struct alignas(64) node_state
+            {
+                rank_type begin = 0, end = 0, chunks = 0;
+                std::atomic<rank_type> next_chunk{0};
+                std::atomic<rank_type> perms{0};
+                std::atomic<unsigned int> workers{0};
+                std::atomic<std::int64_t> max_ns{0};
+            };
+            std::vector<node_state> states(std::size(nodes));
+            {
+                std::vector<unsigned int> per_node(std::size(nodes), 0);
+                for (const auto &w : workers) ++per_node[w.node];
+                rank_type begin = 0;
+                unsigned int before = 0;
+                for (size_t k = 0; k < std::size(nodes); ++k)
+                {
+                    before += per_node[k];
+                    const auto end = permutation_parallel::chunk_begin(total, std::size(workers), before);
+                    states[k].begin = begin;
+                    states[k].end = end;
+                    states[k].chunks = std::min<rank_type>(end - begin, per_node[k] * permutation_parallel::chunks_per_worker);
+                    begin = end;
+                }
+            }
+
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            auto work = [&](const worker &w) {
+                try
+                {
+                    if (w.cpu >= 0)
+                    {
+                        cpu_set_t set;
+                        CPU_ZERO(&set);
+                        CPU_SET(w.cpu, &set);
+                        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);     // best effort
+                    }
+                    const auto user_data = init_worker(w);
+                    const auto start = std::chrono::steady_clock::now();
+                    for (size_t i = 0; i < std::size(states); ++i)
+                    {
+                        auto &st = states[(w.node + i) % std::size(states)];
+                        rank_type perms = 0;
+                        for (rank_type c; (c = st.next_chunk++) < st.chunks; )
+                        {
+                            const auto size = st.end - st.begin;
+                            const auto lo = st.begin + permutation_parallel::chunk_begin(size, st.chunks, c);
+                            const auto hi = st.begin + permutation_parallel::chunk_begin(size, st.chunks, c + 1);
+                            perm_range(first, last, lo, hi, output_each_perm, user_data);
+                            perms += hi - lo;
+                        }
+                        states[w.node].perms += perms;
+                    }
+                    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                    auto &st = states[w.node];
+                    ++st.workers;
+                    for (auto cur = st.max_ns.load(); cur < ns && !st.max_ns.compare_exchange_weak(cur, ns); ) {}
+                }
+                catch (...)
+                {
+                    for (auto &st : states) st.next_chunk = st.chunks;
+                    std::lock_guard lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> pool;
+            for (const auto &w : workers) pool.emplace_back(work, w);
+            for (auto &t : pool) t.join();
+            if (error) std::rethrow_exception(error);
+
+            std::vector<node_report> r;
+            for (size_t k = 0; k < std::size(nodes); ++k)
+            {
+                r.push_back({nodes[k].id, states[k].workers.load(), states[k].perms.load(), states[k].max_ns.load() / 1e9});
+            }
+            return r;
+        }
+    }
+}
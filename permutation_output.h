@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "permutation.h"
+
+namespace permutation_algorithms
+{
+    // Receives a block of formatted output.
+    using block_sink_type = std::function<void(std::string_view)>;
+
+    // Append "e1 e2 ... en \n", the format main.cpp has always printed, to buf.
+    template <std::input_iterator TIter>
+    inline void format_perm(std::string &buf, const TIter first, const TIter last)
+    {
+        for (auto it = first; it != last; ++it)
+        {
+            buf.append(*it);
+            buf.push_back(' ');
+        }
+        buf.push_back('\n');
+    }
+
+    // Formats permutations as text lines and hands them to a sink in blocks
+    // of about batch_size bytes, instead of writing each element to a stream.
+    class output_buffer
+    {
+    public:
+        static constexpr std::size_t default_batch_size = 64 * 1024;
+
+        explicit output_buffer(block_sink_type sink, const std::size_t batch_size = default_batch_size)
+            : sink_(std::move(sink)), batch_size_(batch_size)
+        {
+            buf_.reserve(batch_size_ + 256);
+        }
+        output_buffer(const output_buffer &) = delete;
+        output_buffer &operator=(const output_buffer &) = delete;
+        ~output_buffer()
+        {
+            try { flush(); } catch (...) {}
+        }
+
+        template <std::input_iterator TIter>
+        void append(const TIter first, const TIter last)
+        {
+            format_perm(buf_, first, last);
+            if (buf_.size() >= batch_size_) flush();
+        }
+
+        void append_raw(const std::string_view s)
+        {
+            buf_.append(s);
+            if (buf_.size() >= batch_size_) flush();
+        }
+
+        void flush()
+        {
+            if (buf_.empty()) return;
+            sink_(buf_);
+            buf_.clear();
+        }
+
+        std::size_t batch_size() const { return batch_size_; }
+
+    private:
+        block_sink_type sink_;
+        std::size_t batch_size_;
+        std::string buf_;
+    };
+}
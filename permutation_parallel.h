@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <string>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "permutation.h"
+#include "permutation_output.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    namespace permutation_parallel
+    {
+        // Number of chunks per worker thread; more chunks balance uneven visitors better.
+        constexpr rank_type chunks_per_worker = 8;
+
+        // Return the first rank of chunk c when [0:total) is split into chunks nearly equal chunks.
+        constexpr rank_type chunk_begin(const rank_type total, const rank_type chunks, const rank_type c)
+        {
+            return total / chunks * c + std::min(c, total % chunks);
+        }
+
+        // Return the number of worker threads to use for a request of threads (0 means all cores).
+        inline unsigned int worker_count(const unsigned int threads)
+        {
+            if (threads != 0) return threads;
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Enumerate all permutations of [first:last) by splitting the rank space into
+        // chunks that worker threads take in turn, each calling perm_range on its chunk.
+        // Permutations within a chunk come in the engine's order, but chunks interleave.
+        // worker_data: one user data per worker thread; its size is the number of workers.
+        // output_each_perm is called concurrently, with the user data of the calling worker.
+        inline void perm_all(const perm_range_function_type &perm_range, const perm_iterator_type first, const perm_iterator_type last, output_each_perm_function_type output_each_perm, const std::vector<std::any> &worker_data)
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            if (n == 0 || worker_data.empty()) return;
+            const auto total = permutation_rank::factorial(n);
+            const auto workers = std::size(worker_data);
+            const auto chunks = std::min<rank_type>(total, workers * chunks_per_worker);
+
+            std::atomic<rank_type> next_chunk{0};
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            auto work = [&](const std::any &user_data) {
+                try
+                {
+                    for (rank_type c; (c = next_chunk++) < chunks; )
+                    {
+                        perm_range(first, last, chunk_begin(total, chunks, c), chunk_begin(total, chunks, c + 1), output_each_perm, user_data);
+                    }
+                }
+                catch (...)
+                {
+                    next_chunk = chunks;
+                    std::lock_guard lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(workers - 1);
+            for (size_t i = 1; i < workers; ++i) threads.emplace_back(work, std::cref(worker_data[i]));
+            work(worker_data[0]);
+            for (auto &t : threads) t.join();
+            if (error) std::rethrow_exception(error);
+        }
+
+        // Default number of permutations in a shard of perm_all_ordered().
+        constexpr rank_type default_shard_perms = 16 * 1024;
+
+        // Enumerate all permutations of [first:last) on threads worker threads and pass the
+        // output to sink in exactly the order of a sequential run of the engine.
+        // The rank space is cut into shards of shard_perms permutations. Workers generate
+        // shards concurrently, each into its own buffer: output_each_perm receives a
+        // std::string * to append the permutation to. A reorder stage passes completed
+        // shards to sink in rank order, one call at a time. At most max_pending shards
+        // (0 for 2 * threads) are generated ahead of the next one due, which bounds memory.
+        inline void perm_all_ordered(const perm_range_function_type &perm_range, const perm_iterator_type first, const perm_iterator_type last,
+            output_each_perm_function_type output_each_perm, const block_sink_type &sink, const unsigned int threads,
+            const rank_type shard_perms = default_shard_perms, std::size_t max_pending = 0)
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            if (n == 0) return;
+            const auto total = permutation_rank::factorial(n);
+            const auto workers = std::max(1u, threads);
+            const auto shards = (total + shard_perms - 1) / shard_perms;
+            if (max_pending == 0) max_pending = 2 * workers;
+
+            std::mutex mutex;
+            std::condition_variable window;
+            rank_type next_shard = 0;       // The next shard to generate.
+            rank_type next_emit = 0;        // The next shard to pass to sink.
+            bool emitting = false;          // Whether a worker is passing shards to sink.
+            std::map<rank_type, std::string> done;
+            std::exception_ptr error;
+
+            auto work = [&]() {
+                std::string buf;
+                for (;;)
+                {
+                    rank_type s;
+                    {
+                        std::unique_lock lock(mutex);
+                        window.wait(lock, [&] { return error || next_shard >= shards || next_shard < next_emit + max_pending; });
+                        if (error || next_shard >= shards) return;
+                        s = next_shard++;
+                    }
+                    try
+                    {
+                        buf.clear();
+                        perm_range(first, last, s * shard_perms, std::min(total, (s + 1) * shard_perms), output_each_perm, &buf);
+
+                        std::unique_lock lock(mutex);
+                        done.emplace(s, std::move(buf));
+                        buf = std::string();
+                        if (emitting) continue;
+                        // Become the emitter and pass on every shard that is due, writing outside the lock.
+                        emitting = true;
+                        for (auto it = done.find(next_emit); it != done.end(); it = done.find(next_emit))
+                        {
+                            auto text = std::move(it->second);
+                            done.erase(it);
+                            lock.unlock();
+                            sink(text);
+                            lock.lock();
+                            ++next_emit;
+                            window.notify_all();
+                        }
+                        emitting = false;
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard lock(mutex);
+                        if (!error) error = std::current_exception();
+                        emitting = false;
+                        window.notify_all();
+                        return;
+                    }
+                }
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(workers - 1);
+            for (unsigned int i = 1; i < workers; ++i) pool.emplace_back(work);
+            work();
+            for (auto &t : pool) t.join();
+            if (error) std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "permutation.h"
+#include "permutation_output.h"
+#include "permutation_registry.h"
+
+namespace permutation_algorithms
+{
+    namespace pipeline
+    {
+        constexpr std::size_t cache_line_size = 64;
+
+        // Bounded lock-free queue for one producer thread and one consumer thread.
+        template <typename T>
+        class spsc_ring
+        {
+        public:
+            // capacity is rounded up to a power of two.
+            explicit spsc_ring(const std::size_t capacity)
+                : buf_(std::bit_ceil(std::max<std::size_t>(capacity, 2))), mask_(std::size(buf_) - 1)
+            {
+            }
+
+            bool try_push(const T &v)
+            {
+                const auto tail = tail_.load(std::memory_order_relaxed);
+                if (tail - cached_head_ == std::size(buf_))
+                {
+                    cached_head_ = head_.load(std::memory_order_acquire);
+                    if (tail - cached_head_ == std::size(buf_)) return false;
+                }
+                buf_[tail & mask_] = v;
+                tail_.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool try_pop(T &v)
+            {
+                const auto head = head_.load(std::memory_order_relaxed);
+                if (head == cached_tail_)
+                {
+                    cached_tail_ = tail_.load(std::memory_order_acquire);
+                    if (head == cached_tail_) return false;
+                }
+                v = buf_[head & mask_];
+                head_.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+        private:
+            std::vector<T> buf_;
+            const std::size_t mask_;
+            // The consumer's index and its copy of the producer's, then the reverse,
+            // on separate cache lines.
+            alignas(cache_line_size) std::atomic<std::size_t> head_{0};
+            std::size_t cached_tail_ = 0;
+            alignas(cache_line_size) std::atomic<std::size_t> tail_{0};
+            std::size_t cached_head_ = 0;
+        };
+
+        // Bounded lock-free queue for any number of producers and consumers.
+        // Vyukov, D. Bounded MPMC queue. https://www.1024cores.net/
+        template <typename T>
+        class mpmc_ring
+        {
+        public:
+            // capacity is rounded up to a power of two.
+            explicit mpmc_ring(const std::size_t capacity)
+                : cells_(std::bit_ceil(std::max<std::size_t>(capacity, 2))), mask_(std::size(cells_) - 1)
+            {
+                for (std::size_t i = 0; i < std::size(cells_); ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+            }
+
+            bool try_push(const T &v)
+            {
+                auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    auto &cell = cells_[pos & mask_];
+                    const auto seq = cell.seq.load(std::memory_order_acquire);
+                    const auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                    if (dif == 0)
+                    {
+                        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            cell.data = v;
+                            cell.seq.store(pos + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (dif < 0)
+                    {
+                        return false;
+                    }
+                    else
+                    {
+                        pos = enqueue_pos_.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            bool try_pop(T &v)
+            {
+                auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    auto &cell = cells_[pos & mask_];
+                    const auto seq = cell.seq.load(std::memory_order_acquire);
+                    const auto dif = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+                    if (dif == 0)
+                    {
+                        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        {
+                            v = cell.data;
+                            cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (dif < 0)
+                    {
+                        return false;
+                    }
+                    else
+                    {
+                        pos = dequeue_pos_.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+        private:
+            struct cell
+            {
+                std::atomic<std::size_t> seq;
+                T data;
+            };
+
+            std::vector<cell> cells_;
+            const std::size_t mask_;
+            alignas(cache_line_size) std::atomic<std::size_t> enqueue_pos_{0};
+            alignas(cache_line_size) std::atomic<std::size_t> dequeue_pos_{0};
+        };
+
+        // Wait until pred() holds, spinning briefly before yielding the CPU.
+        template <typename TPred>
+        inline void wait_until(TPred pred)
+        {
+            for (int spins = 0; !pred(); )
+            {
+                if (spins < 64) ++spins;
+                else std::this_thread::yield();
+            }
+        }
+
+        // Permutations passed from the generator to the consumers.
+        struct perm_batch
+        {
+            std::uint64_t seq = 0;          // Position of the batch in the generator's output.
+            std::size_t n = 0;              // Elements per permutation.
+            std::size_t count = 0;          // Permutations in the batch.
+            std::vector<elem_type> elems;   // count * n elements.
+
+            perm_iterator_type perm_begin(const std::size_t i) const { return std::next(std::cbegin(elems), i * n); }
+            perm_iterator_type perm_end(const std::size_t i) const { return std::next(std::cbegin(elems), (i + 1) * n); }
+        };
+
+        struct options
+        {
+            std::size_t depth = 64;         // Batches the queue holds before the generator waits.
+            unsigned int consumers = 1;
+            std::size_t batch_perms = 1024; // Permutations per batch.
+        };
+
+        // Called on a consumer thread for each batch, with the index of the consumer.
+        using consume_function_type = std::function<void(const perm_batch &, unsigned int)>;
+
+        namespace detail
+        {
+            // Run the generator on this thread and consumers on their own threads, passing
+            // batches through TQueue and returning them through a free list.
+            template <template <typename> typename TQueue>
+            inline void run(const perm_all_function_type &perm_all, const perm_iterator_type first, const perm_iterator_type last,
+                const options &opts, const consume_function_type &consume)
+            {
+                const auto n = static_cast<std::size_t>(std::distance(first, last));
+                const auto consumers = std::max(1u, opts.consumers);
+                const auto batch_perms = std::max<std::size_t>(opts.batch_perms, 1);
+
+                // Enough batches that the generator waits only when the queue is full.
+                std::vector<perm_batch> pool(opts.depth + consumers + 1);
+                TQueue<perm_batch *> queue(opts.depth);
+                mpmc_ring<perm_batch *> free_list(std::size(pool));
+                for (auto &b : pool)
+                {
+                    b.n = n;
+                    b.elems.reserve(batch_perms * n);
+                    free_list.try_push(&b);
+                }
+
+                std::atomic<bool> failed{false};
+                std::exception_ptr error;
+                std::mutex error_mutex;
+                auto fail = [&] {
+                    std::lock_guard lock(error_mutex);
+                    if (!error) error = std::current_exception();
+                    failed = true;
+                };
+
+                std::vector<std::thread> threads;
+                for (unsigned int i = 0; i < consumers; ++i)
+                {
+                    threads.emplace_back([&, i] {
+                        for (;;)
+                        {
+                            perm_batch *b = nullptr;
+                            wait_until([&] { return queue.try_pop(b) || failed; });
+                            if (!b) return;     // end of input, or failed
+                            try
+                            {
+                                if (!failed) consume(*b, i);
+                            }
+                            catch (...)
+                            {
+                                fail();
+                            }
+                            wait_until([&] { return free_list.try_push(b); });
+                        }
+                    });
+                }
+
+                std::uint64_t seq = 0;
+                perm_batch *cur = nullptr;
+                auto push_current = [&] {
+                    wait_until([&] { return queue.try_push(cur) || failed; });
+                    cur = nullptr;
+                };
+                try
+                {
+                    perm_all(first, last,
+                        [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) {
+                            if (!cur)
+                            {
+                                wait_until([&] { return free_list.try_pop(cur) || failed; });
+                                if (failed) throw std::runtime_error("pipeline consumer failed");
+                                cur->seq = seq++;
+                                cur->count = 0;
+                                cur->elems.clear();
+                            }
+                            cur->elems.insert(std::end(cur->elems), f, l);
+                            if (++cur->count == batch_perms) push_current();
+                        },
+                        {});
+                    if (cur) push_current();
+                }
+                catch (...)
+                {
+                    if (!failed) fail();
+                }
+                // One end marker per consumer.
+                for (unsigned int i = 0; i < consumers; ++i) wait_until([&] { return queue.try_push(nullptr) || failed; });
+                for (auto &t : threads) t.join();
+                if (error) std::rethrow_exception(error);
+            }
+        }
+
+        // Enumerate with perm_all on this thread while opts.consumers threads call consume
+        // for each batch of opts.batch_perms permutations. Batches pass through a lock-free
+        // queue of opts.depth batches; the generator waits while it is full.
+        // Batches may be consumed out of order by several consumers; perm_batch::seq
+        // gives their order.
+        inline void run(const perm_all_function_type &perm_all, const perm_iterator_type first, const perm_iterator_type last,
+            const options &opts, const consume_function_type &consume)
+        {
+            if (opts.consumers <= 1) detail::run<spsc_ring>(perm_all, first, last, opts, consume);
+            else detail::run<mpmc_ring>(perm_all, first, last, opts, consume);
+        }
+
+        // Passes blocks numbered 0, 1, 2, ... to a sink in number order, whatever the
+        // order they are written in. Thread-safe.
+        class reorder_sink
+        {
+        public:
+            explicit reorder_sink(block_sink_type sink) : sink_(std::move(sink)) {}
+
+            void write(const std::uint64_t seq, std::string block)
+            {
+                std::lock_guard lock(mutex_);
+                pending_.emplace(seq, std::move(block));
+                for (auto it = pending_.find(next_); it != pending_.end(); it = pending_.find(++next_))
+                {
+                    sink_(it->second);
+                    pending_.erase(it);
+                }
+            }
+
+        private:
+            block_sink_type sink_;
+            std::mutex mutex_;
+            std::map<std::uint64_t, std::string> pending_;
+            std::uint64_t next_ = 0;
+        };
+    }
+}
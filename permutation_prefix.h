@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "permutation.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    // Evaluation of a function of each permutation that is computed element by element,
+    // reusing the partial results of the prefix the permutation shares with the previous.
+    // The function is given as step(state, element, position), returning the state after
+    // appending element at position to a prefix whose state is state.
+    namespace prefix_eval
+    {
+        // Algorithm L: rearrange [first:last) into its lexicographic successor and return
+        // the first position that changed, or the size if it was the last permutation,
+        // which is then rearranged into the first.
+        template <std::random_access_iterator TIter>
+        inline std::size_t next_permutation_pivot(const TIter first, const TIter last)
+        {
+            const auto n = static_cast<std::size_t>(std::distance(first, last));
+            if (n < 2) return n;
+            auto j = n - 2;
+            while (!(first[j] < first[j + 1]))
+            {
+                if (j == 0)
+                {
+                    std::reverse(first, last);
+                    return n;
+                }
+                --j;
+            }
+            auto l = n - 1;
+            while (!(first[j] < first[l])) --l;
+            std::iter_swap(first + j, first + l);
+            std::reverse(first + j + 1, last);
+            return j;
+        }
+
+        namespace detail
+        {
+            // Visit a and the following permutations until the last or until count have been
+            // visited, keeping states[i] the state of the prefix a[0:i). Returns the step calls.
+            template <typename TState, typename TStep, typename TVisit>
+            inline std::uint64_t run_lex(perm_type &a, std::vector<TState> &states, std::uint64_t count, TStep &step, TVisit &visit)
+            {
+                const auto n = std::size(a);
+                std::uint64_t steps = 0;
+                std::size_t from = 0;
+                for (;;)
+                {
+                    for (auto i = from; i < n; ++i) states[i + 1] = step(static_cast<const TState &>(states[i]), a[i], i);
+                    steps += n - from;
+                    visit(std::cbegin(a), std::cend(a), static_cast<const TState &>(states[n]));
+                    if (--count == 0) return steps;
+                    from = next_permutation_pivot(std::begin(a), std::end(a));
+                    if (from == n) return steps;
+                }
+            }
+        }
+
+        // Call visit(first, last, state) for every permutation of [first:last), of distinct
+        // elements, in lexicographic order, where state is the result of folding step over
+        // the permutation from initial. Only the suffix from the pivot of Algorithm L is
+        // folded again, on average fewer than e = 2.718... positions per permutation
+        // instead of n.
+        // Returns the number of step calls.
+        template <typename TState, typename TStep, typename TVisit>
+        inline std::uint64_t perm_all_lex(const perm_iterator_type first, const perm_iterator_type last, const TState &initial, TStep step, TVisit visit)
+        {
+            perm_type a(first, last);
+            if (a.empty()) return 0;
+            std::sort(std::begin(a), std::end(a));
+            std::vector<TState> states(std::size(a) + 1, initial);
+            return detail::run_lex(a, states, std::numeric_limits<std::uint64_t>::max(), step, visit);
+        }
+
+        // As perm_all_lex, for the permutations of rank [rank_first:rank_last); the first
+        // is folded in full. For splitting an evaluation across threads.
+        template <typename TState, typename TStep, typename TVisit>
+        inline std::uint64_t perm_range_lex(const perm_iterator_type first, const perm_iterator_type last, const rank_type rank_first, const rank_type rank_last,
+            const TState &initial, TStep step, TVisit visit)
+        {
+            perm_type a(first, last);
+            if (rank_first >= rank_last) return 0;
+            if (rank_last > permutation_rank::factorial(static_cast<unsigned int>(std::size(a)))) throw std::out_of_range("rank out of range");
+            std::sort(std::begin(a), std::end(a));
+            permutation_rank::unrank_lex(std::begin(a), std::end(a), rank_first);
+            std::vector<TState> states(std::size(a) + 1, initial);
+            return detail::run_lex(a, states, rank_last - rank_first, step, visit);
+        }
+    }
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include "permutation.h"
+
+namespace permutation_algorithms
+{
+    // Rank of a permutation, i.e. its 0-based position in an enumeration order.
+    using rank_type = std::uint64_t;
+    using perm_range_function_type = std::function<void(const perm_iterator_type, const perm_iterator_type, const rank_type, const rank_type, output_each_perm_function_type, const std::any &)>;
+
+    namespace permutation_rank
+    {
+        // The largest n whose n! fits in rank_type.
+        constexpr unsigned int max_rank_n = 20;
+
+        // Return n!. Throws std::overflow_error if it does not fit in rank_type.
+        constexpr rank_type factorial(unsigned int n)
+        {
+            if (n > max_rank_n) throw std::overflow_error("factorial overflow");
+            rank_type r = 1;
+            while (n > 1) r *= n--;
+            return r;
+        }
+
+        // Rearrange [first:last), which must be sorted and have distinct elements,
+        // into the permutation of rank r in lexicographic order.
+        template <std::random_access_iterator TIter>
+        inline void unrank_lex(const TIter first, const TIter last, rank_type r)
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            if (r >= factorial(n)) throw std::out_of_range("rank out of range");
+            for (unsigned int i = 0; i + 1 < n; ++i)
+            {
+                // The i-th digit of the factorial number system picks which of the
+                // remaining elements comes next; rotate it to the front.
+                const auto f = factorial(n - 1 - i);
+                const auto d = r / f;
+                r %= f;
+                std::rotate(std::next(first, i), std::next(first, i + d), std::next(first, i + d + 1));
+            }
+        }
+
+        // Return the rank in lexicographic order of the permutation [first:last)
+        // of distinct elements.
+        template <std::random_access_iterator TIter>
+        inline rank_type rank_lex(const TIter first, const TIter last)
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            rank_type r = 0;
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                // Lehmer code: the number of following elements less than this one.
+                rank_type d = 0;
+                for (auto j = i + 1; j < n; ++j)
+                {
+                    if (first[j] < first[i]) ++d;
+                }
+                r += d * factorial(n - 1 - i);
+            }
+            return r;
+        }
+    }
+
+    namespace permutation_rank
+    {
+        // Return the counters c[0:n) of Heap's algorithm (permutation4) right after it
+        // outputs the permutation of rank r. c[i] counts the swaps done at level i and
+        // r = sum of c[i] * i!, so the counters are the factorial digits of r.
+        inline std::vector<int> heap_counters(const unsigned int n, rank_type r)
+        {
+            if (r >= factorial(n)) throw std::out_of_range("rank out of range");
+            std::vector<int> c(n, 0);
+            for (unsigned int i = 1; i < n; ++i)
+            {
+                c[i] = static_cast<int>(r % (i + 1));
+                r /= i + 1;
+            }
+            return c;
+        }
+
+        // Rearrange [first:last) into the permutation of rank r in the order of Heap's
+        // algorithm started from [first:last). O(n^3).
+        template <std::random_access_iterator TIter>
+        inline void unrank_heap(const TIter first, const TIter last, const rank_type r)
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            const auto c = heap_counters(n, r);
+
+            // net[k][p]: the position whose element is at p after all permutations of
+            // the first k elements have been generated.
+            std::vector<std::vector<unsigned int>> net(n + 1);
+            auto apply = [](const std::vector<unsigned int> &mapping, auto f) {
+                std::vector<typename std::iterator_traits<decltype(f)>::value_type> tmp(f, f + std::size(mapping));
+                for (size_t p = 0; p < std::size(mapping); ++p) f[p] = tmp[mapping[p]];
+            };
+            // The swap done before block j at level k, i.e. at counter index k-1.
+            auto swap_before = [](const unsigned int k, const unsigned int j, auto f) {
+                using std::swap;
+                if ((k - 1) % 2 == 0) swap(f[0], f[k - 1]);
+                else swap(f[j], f[k - 1]);
+            };
+            for (unsigned int k = 1; k <= n; ++k)
+            {
+                std::vector<unsigned int> idx(k);
+                for (unsigned int p = 0; p < k; ++p) idx[p] = p;
+                if (k > 1)
+                {
+                    apply(net[k - 1], std::begin(idx));
+                    for (unsigned int j = 0; j + 1 < k; ++j)
+                    {
+                        swap_before(k, j, std::begin(idx));
+                        apply(net[k - 1], std::begin(idx));
+                    }
+                }
+                net[k] = std::move(idx);
+            }
+
+            // Skip c[k-1] whole blocks at each level, from the top.
+            for (auto k = n; k > 1; --k)
+            {
+                for (int j = 0; j < c[k - 1]; ++j)
+                {
+                    apply(net[k - 1], first);
+                    swap_before(k, j, first);
+                }
+            }
+        }
+
+        // Return the digits of permutation1::generator at the permutation of rank r: the
+        // digit of the last element has radix n and changes fastest.
+        inline std::vector<int> insertion_digits(const unsigned int n, rank_type r)
+        {
+            if (r >= factorial(n)) throw std::out_of_range("rank out of range");
+            std::vector<int> d(n, 0);
+            for (auto k = n; k-- > 1; )
+            {
+                d[k] = static_cast<int>(r % (k + 1));
+                r /= k + 1;
+            }
+            return d;
+        }
+
+        // Return the rank of the permutation of permutation1::generator with digits d.
+        inline rank_type insertion_rank(const std::vector<int> &d)
+        {
+            rank_type r = 0;
+            for (std::size_t k = 1; k < std::size(d); ++k) r = r * (k + 1) + d[k];
+            return r;
+        }
+
+        // State of Algorithm P (permutation2) right after it outputs the permutation of rank r.
+        struct plain_changes_state
+        {
+            std::vector<int> c;             // c[j] in [0:j]: how far element j has moved from the right.
+            std::vector<signed char> o;     // o[j]: the direction element j moves next.
+        };
+
+        // The counters c form a reflected mixed-radix Gray code of r: digit j has radix j+1,
+        // and runs down instead of up when the number formed by the digits before it is odd.
+        inline plain_changes_state plain_changes_counters(const unsigned int n, rank_type r)
+        {
+            if (r >= factorial(n)) throw std::out_of_range("rank out of range");
+            std::vector<rank_type> digit(n, 0);
+            for (auto j = n; j-- > 1; )
+            {
+                digit[j] = r % (j + 1);
+                r /= j + 1;
+            }
+            plain_changes_state st{std::vector<int>(n, 0), std::vector<signed char>(n, 1)};
+            rank_type prefix_parity = 0;
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                st.o[j] = prefix_parity ? -1 : 1;
+                st.c[j] = static_cast<int>(prefix_parity ? j - digit[j] : digit[j]);
+                prefix_parity = (prefix_parity * ((j + 1) & 1) + digit[j]) & 1;
+            }
+            return st;
+        }
+
+        // Rearrange [first:last) into the permutation of rank r in plain changes order
+        // (Algorithm P) started from [first:last). O(n^2).
+        template <std::random_access_iterator TIter>
+        inline void unrank_plain_changes(const TIter first, const TIter last, const rank_type r)
+        {
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            const auto st = plain_changes_counters(n, r);
+            // Element j stands at index j - c[j] among elements 0..j.
+            std::vector<typename std::iterator_traits<TIter>::value_type> a;
+            a.reserve(n);
+            for (unsigned int j = 0; j < n; ++j) a.insert(std::next(std::begin(a), j - st.c[j]), first[j]);
+            std::copy(std::begin(a), std::end(a), first);
+        }
+    }
+
+    namespace permutation_std
+    {
+        // Permutations of rank [rank_first:rank_last) in lexicographic order.
+        // [first:last): Elements to permute. They must be distinct: perm_all() skips
+        // repeated arrangements, so ranks of n! permutations would not match it.
+        // Throws std::invalid_argument if they are not.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm_range(const TIter first, const TIter last, const rank_type rank_first, const rank_type rank_last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            if (rank_first >= rank_last) return;
+            if (rank_last > permutation_rank::factorial(static_cast<unsigned int>(std::distance(first, last)))) throw std::out_of_range("rank out of range");
+            perm_type a{first, last};
+            std::sort(std::begin(a), std::end(a));
+            if (std::adjacent_find(std::cbegin(a), std::cend(a)) != std::cend(a)) throw std::invalid_argument("elements are not distinct");
+            permutation_rank::unrank_lex(std::begin(a), std::end(a), rank_first);
+            for (auto r = rank_first; ; )
+            {
+                output_each_perm(std::cbegin(a), std::cend(a), user_data);
+                if (++r == rank_last) break;
+                std::next_permutation(std::begin(a), std::end(a));
+            }
+        }
+    }
+
+    namespace permutation1
+    {
+        // Permutations of rank [rank_first:rank_last) in the order perm_all() generates them.
+        // [first:last): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm_range(const TIter first, const TIter last, const rank_type rank_first, const rank_type rank_last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            if (rank_first >= rank_last) return;
+            const auto n = static_cast<unsigned int>(std::distance(first, last));
+            if (rank_last > permutation_rank::factorial(n)) throw std::out_of_range("rank out of range");
+            generator g(first, last, permutation_rank::insertion_digits(n, rank_first));
+            for (auto r = rank_first; ; )
+            {
+                output_each_perm(std::cbegin(g), std::cend(g), user_data);
+                if (++r == rank_last) break;
+                g.next();
+            }
+        }
+    }
+
+    namespace permutation4
+    {
+        // Permutations of rank [rank_first:rank_last) in the order perm_all() generates them.
+        // [first:last): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm_range(const TIter first, const TIter last, const rank_type rank_first, const rank_type rank_last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            if (rank_first >= rank_last) return;
+            if (rank_last > permutation_rank::factorial(static_cast<unsigned int>(std::distance(first, last)))) throw std::out_of_range("rank out of range");
+            perm_type a{first, last};
+            const auto n = static_cast<int>(std::size(a));
+            permutation_rank::unrank_heap(std::begin(a), std::end(a), rank_first);
+            auto c = permutation_rank::heap_counters(n, rank_first);
+            output_each_perm(std::cbegin(a), std::cend(a), user_data);
+            // The loop of perm() resumed from the counters.
+            for (auto r = rank_first + 1; r < rank_last; ++r)
+            {
+                for (int i = 1; i < n;)
+                {
+                    if (c[i] < i)
+                    {
+                        using namespace std;
+                        if ((i&1) == 0) swap(a[0], a[i]);
+                        else swap(a[c[i]], a[i]);
+                        output_each_perm(std::cbegin(a), std::cend(a), user_data);
+                        ++c[i];
+                        break;
+                    }
+                    c[i] = 0;
+                    ++i;
+                }
+            }
+        }
+    }
+
+    namespace permutation2
+    {
+        // Permutations of rank [rank_first:rank_last) in the order perm_all() generates them.
+        // [first:last): Elements to permute.
+        // output_each_perm: output function of which a permutation should be passed as parameters.
+        template <std::random_access_iterator TIter>
+            requires std::convertible_to<typename std::iterator_traits<TIter>::value_type, elem_type>
+        inline void perm_range(const TIter first, const TIter last, const rank_type rank_first, const rank_type rank_last, output_each_perm_function_type output_each_perm, const std::any &user_data)
+        {
+            if (rank_first >= rank_last) return;
+            if (rank_last > permutation_rank::factorial(static_cast<unsigned int>(std::distance(first, last)))) throw std::out_of_range("rank out of range");
+            perm_type a{first, last};
+            const auto sz = static_cast<int>(std::size(a));
+            permutation_rank::unrank_plain_changes(std::begin(a), std::end(a), rank_first);
+            auto [c, o] = permutation_rank::plain_changes_counters(sz, rank_first);
+            output_each_perm(std::cbegin(a), std::cend(a), user_data);
+            // The loop of perm_all() resumed from the counters.
+            for (auto r = rank_first + 1; r < rank_last; ++r)
+            {
+                for (int s = 0, j = sz - 1, q; ; --j)
+                {
+                    q = c[j] + o[j];
+                    if (q >= 0)
+                    {
+                        if (q != j + 1)
+                        {
+                            using namespace std;
+                            swap(a[j - c[j] + s], a[j - q + s]);
+                            c[j] = q;
+                            break;
+                        }
+                        ++s;
+                    }
+                    o[j] = -o[j];
+                }
+                output_each_perm(std::cbegin(a), std::cend(a), user_data);
+            }
+        }
+    }
+}
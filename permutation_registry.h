@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "permutation.h"
+#include "permutation_heap_table.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    using perm_all_function_type = std::function<void(const perm_iterator_type, const perm_iterator_type, output_each_perm_function_type, const std::any &)>;
+
+    namespace registry
+    {
+        // Order in which an engine emits permutations.
+        enum class perm_order
+        {
+            lexicographic,  // sorted order of std::next_permutation()
+            insertion,      // Knuth Vol.1 1.2.5 Method 1
+            plain_changes,  // Knuth Vol.4A Algorithm P (Steinhaus-Johnson-Trotter)
+            heap,           // Heap (1963)
+        };
+
+        inline std::string_view to_string(const perm_order order)
+        {
+            switch (order)
+            {
+            case perm_order::lexicographic: return "lexicographic";
+            case perm_order::insertion: return "insertion";
+            case perm_order::plain_changes: return "plain_changes";
+            case perm_order::heap: return "heap";
+            }
+            return "unknown";
+        }
+
+        inline perm_order parse_order(const std::string_view s)
+        {
+            for (const auto order : {perm_order::lexicographic, perm_order::insertion, perm_order::plain_changes, perm_order::heap})
+            {
+                if (s == to_string(order)) return order;
+            }
+            throw std::domain_error("unknown order " + std::string(s));
+        }
+
+        struct engine_properties
+        {
+            perm_order order;
+            std::size_t max_n;          // The largest number of elements accepted.
+            bool transposition;         // Successive permutations differ by a swap of two elements.
+            bool adjacent;              // Successive permutations differ by a swap of two adjacent elements.
+            bool supports_range;        // Can start at and stop before a given rank.
+            bool supports_parallel;     // Can split the enumeration among threads.
+        };
+
+        struct engine
+        {
+            std::string name;
+            std::string description;
+            engine_properties properties;
+            int cost;                   // Relative cost per permutation, lower is faster.
+            perm_all_function_type perm_all;
+            perm_range_function_type perm_range;    // Empty unless properties.supports_range.
+        };
+
+        // All generator engines, in the order they are listed by the CLI.
+        inline const std::vector<engine> &engines()
+        {
+            constexpr auto int_max = static_cast<std::size_t>(std::numeric_limits<int>::max());
+            constexpr auto size_max = std::numeric_limits<std::size_t>::max();
+            static const std::vector<engine> r{
+                {"std", "std::next_permutation (Algorithm L)",
+                    {perm_order::lexicographic, size_max, false, false, true, true}, 3,
+                    permutation_std::perm_all<perm_iterator_type>, permutation_std::perm_range<perm_iterator_type>},
+                {"1", "Insertion into permutations of n-1 elements (iterative)",
+                    {perm_order::insertion, size_max, false, false, true, true}, 3,
+                    permutation1::perm_all<perm_iterator_type>, permutation1::perm_range<perm_iterator_type>},
+                {"2", "Plain changes (Algorithm P)",
+                    {perm_order::plain_changes, int_max, true, true, true, true}, 2,
+                    permutation2::perm_all<perm_iterator_type>, permutation2::perm_range<perm_iterator_type>},
+                {"3", "Heap's algorithm (recursive)",
+                    {perm_order::heap, int_max, true, false, false, false}, 4,
+                    permutation3::perm_all<perm_iterator_type>, nullptr},
+                {"4", "Heap's algorithm (non-recursive)",
+                    {perm_order::heap, int_max, true, false, true, true}, 1,
+                    permutation4::perm_all<perm_iterator_type>, permutation4::perm_range<perm_iterator_type>},
+                {"5", "Heap's algorithm (precomputed swap table)",
+                    {perm_order::heap, int_max, true, false, true, true}, 1,
+                    permutation5::perm_all<perm_iterator_type>, permutation5::perm_range<perm_iterator_type>},
+            };
+            return r;
+        }
+
+        // Return the engine named name, or nullptr.
+        inline const engine *find_engine(const std::string_view name)
+        {
+            for (const auto &e : engines())
+            {
+                if (e.name == name) return &e;
+            }
+            return nullptr;
+        }
+
+        // Return the engine named name. Throws std::domain_error if there is no such engine.
+        inline const engine &get_engine(const std::string_view name)
+        {
+            const auto e = find_engine(name);
+            if (!e) throw std::domain_error("unknown algorithm " + std::string(name));
+            return *e;
+        }
+
+        // What a caller needs from an engine; used by select_engine().
+        struct requirements
+        {
+            std::size_t n = 0;
+            std::optional<perm_order> order;
+            bool range = false;
+            bool parallel = false;
+            // Some elements repeat, so lexicographic ranks do not address permutations.
+            bool repeated = false;
+        };
+
+        inline bool satisfies(const engine &e, const requirements &req)
+        {
+            const auto &p = e.properties;
+            if (req.n > p.max_n) return false;
+            if (req.order && *req.order != p.order) return false;
+            if (req.range && (!p.supports_range || req.n > permutation_rank::max_rank_n)) return false;
+            if (req.parallel && (!p.supports_parallel || req.n > permutation_rank::max_rank_n)) return false;
+            if (req.repeated && (req.range || req.parallel) && p.order == perm_order::lexicographic) return false;
+            return true;
+        }
+
+        // Pick the fastest engine satisfying req.
+        // Throws std::domain_error if no engine does.
+        inline const engine &select_engine(const requirements &req)
+        {
+            const engine *best = nullptr;
+            for (const auto &e : engines())
+            {
+                if (!satisfies(e, req)) continue;
+                if (!best || e.cost < best->cost) best = &e;
+            }
+            if (!best) throw std::domain_error("no algorithm satisfies the requirements");
+            return *best;
+        }
+    }
+}
@@ -0,0 +1,493 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "permutation.h"
+#include "permutation_autotune.h"
+#include "permutation_rank.h"
+#include "permutation_registry.h"
+
+// Job server over a Unix domain socket.
+//
+// A client sends any number of jobs on a connection and reads each job's reply
+// before sending the next. Integers are in host byte order; the socket is local.
+//
+// Job:
+//   u8  'J'
+//   u8  flags              bit 0: count only; bit 1: rank range follows
+//   u8  algorithm length, then the algorithm name (an engine name or "auto")
+//   u64 rank_first, u64 rank_last      if flags bit 1
+//   u32 number of elements, then for each: u32 length and bytes
+//
+// Reply, a sequence of frames:
+//   u8 'P', u32 k, k * n bytes       k permutations as 0-based element indices
+//   u8 'E', u64 count                end of job
+//   u8 'X', u32 length, message      the job failed; the connection stays usable
+namespace permutation_algorithms
+{
+    namespace server
+    {
+        constexpr std::size_t max_elements = 255;   // An element index fits in a byte.
+        constexpr std::size_t io_buffer_size = 64 * 1024;
+        constexpr std::uint8_t flag_count_only = 1;
+        constexpr std::uint8_t flag_range = 2;
+        // Permutations between checks of whether the server is stopping; a power of 2.
+        constexpr int64_t stop_check_interval = 64 * 1024;
+
+        struct job_request
+        {
+            std::vector<std::string> elements;
+            std::string algorithm = "auto";
+            bool count_only = false;
+            std::optional<std::pair<rank_type, rank_type>> range;
+        };
+
+        namespace detail
+        {
+            [[noreturn]] inline void throw_errno(const char *what)
+            {
+                throw std::system_error(errno, std::generic_category(), what);
+            }
+
+            inline sockaddr_un make_address(const std::filesystem::path &path)
+            {
+                sockaddr_un addr{};
+                addr.sun_family = AF_UNIX;
+                const auto s = path.string();
+                if (std::size(s) >= sizeof(addr.sun_path)) throw std::invalid_argument("socket path too long: " + s);
+                std::memcpy(addr.sun_path, s.c_str(), std::size(s) + 1);
+                return addr;
+            }
+
+            // Buffered reads from a socket.
+            class reader
+            {
+            public:
+                explicit reader(const int fd) : fd_(fd), buf_(io_buffer_size) {}
+
+                // Read size bytes; return false if the peer closed before the first byte.
+                // Throws std::runtime_error if it closed in the middle.
+                bool read(void *dest, std::size_t size)
+                {
+                    auto p = static_cast<char *>(dest);
+                    bool started = false;
+                    while (size > 0)
+                    {
+                        if (pos_ == end_)
+                        {
+                            const auto r = ::read(fd_, std::data(buf_), std::size(buf_));
+                            if (r < 0 && errno == EINTR) continue;
+                            if (r < 0) throw_errno("read");
+                            if (r == 0)
+                            {
+                                if (!started) return false;
+                                throw std::runtime_error("connection closed in the middle of a message");
+                            }
+                            pos_ = 0;
+                            end_ = static_cast<std::size_t>(r);
+                        }
+                        const auto n = std::min(size, end_ - pos_);
+                        std::memcpy(p, &buf_[pos_], n);
+                        pos_ += n;
+                        p += n;
+                        size -= n;
+                        started = true;
+                    }
+                    return true;
+                }
+
+                template <typename T>
+                T get()
+                {
+                    T v;
+                    if (!read(&v, sizeof(v))) throw std::runtime_error("connection closed in the middle of a message");
+                    return v;
+                }
+
+                std::string get_string(const std::size_t size)
+                {
+                    std::string s(size, '\0');
+                    if (size > 0 && !read(std::data(s), size)) throw std::runtime_error("connection closed in the middle of a message");
+                    return s;
+                }
+
+            private:
+                int fd_;
+                std::vector<char> buf_;
+                std::size_t pos_ = 0, end_ = 0;
+            };
+
+            // Buffered writes to a socket.
+            class writer
+            {
+            public:
+                explicit writer(const int fd) : fd_(fd) { buf_.reserve(io_buffer_size); }
+
+                template <typename T>
+                void put(const T &v)
+                {
+                    put_bytes(&v, sizeof(v));
+                }
+
+                void put_bytes(const void *src, const std::size_t size)
+                {
+                    const auto p = static_cast<const char *>(src);
+                    buf_.insert(std::end(buf_), p, p + size);
+                }
+
+                std::size_t size() const { return std::size(buf_); }
+
+                void flush()
+                {
+                    std::size_t done = 0;
+                    while (done < std::size(buf_))
+                    {
+                        const auto r = ::send(fd_, std::data(buf_) + done, std::size(buf_) - done, MSG_NOSIGNAL);
+                        if (r < 0 && errno == EINTR) continue;
+                        if (r < 0) throw_errno("send");
+                        done += static_cast<std::size_t>(r);
+                    }
+                    buf_.clear();
+                }
+
+            private:
+                int fd_;
+                std::vector<char> buf_;
+            };
+
+            // Reusable state of one connection.
+            struct connection
+            {
+                explicit connection(const int fd) : in(fd), out(fd) {}
+
+                reader in;
+                writer out;
+                std::string storage;            // Elements separated by NUL, so that each has a distinct offset.
+                std::vector<std::uint8_t> index_at; // Element index by offset into storage.
+                perm_type elems;
+                std::vector<std::uint8_t> batch;   // Indices of the permutations in the current 'P' frame.
+                std::uint32_t batch_perms = 0;
+                int64_t count = 0;
+                bool count_only = false;
+                const std::atomic<bool> *stopping = nullptr;
+
+                void flush_batch()
+                {
+                    if (batch_perms == 0) return;
+                    out.put('P');
+                    out.put(batch_perms);
+                    out.put_bytes(std::data(batch), std::size(batch));
+                    batch.clear();
+                    batch_perms = 0;
+                    out.flush();
+                }
+
+                static void each_perm(const perm_iterator_type first, const perm_iterator_type last, const std::any &user_data)
+                {
+                    auto c = std::any_cast<connection *>(user_data);
+                    ++c->count;
+                    // A count-only job writes nothing to notice the socket shut down by stop().
+                    if ((c->count & (stop_check_interval - 1)) == 0 && c->stopping && c->stopping->load(std::memory_order_relaxed))
+                    {
+                        throw std::runtime_error("server stopping");
+                    }
+                    if (c->count_only) return;
+                    for (auto it = first; it != last; ++it)
+                    {
+                        c->batch.push_back(c->index_at[it->data() - std::data(c->storage)]);
+                    }
+                    ++c->batch_perms;
+                    if (std::size(c->batch) >= io_buffer_size) c->flush_batch();
+                }
+            };
+
+            // Read one job from c and reply to it. Return false when the client has closed.
+            // "auto" picks the engine from prof like the CLI's --algorithm auto, but jobs run
+            // on their connection's thread.
+            inline bool serve_job(connection &c, const autotune::profile *prof)
+            {
+                std::uint8_t tag;
+                if (!c.in.read(&tag, 1)) return false;
+                if (tag != 'J') throw std::runtime_error("bad job tag");
+                const auto flags = c.in.get<std::uint8_t>();
+                const auto algorithm = c.in.get_string(c.in.get<std::uint8_t>());
+                std::optional<std::pair<rank_type, rank_type>> range;
+                if (flags & flag_range)
+                {
+                    const auto rank_first = c.in.get<std::uint64_t>();
+                    range.emplace(rank_first, c.in.get<std::uint64_t>());
+                }
+                const auto n = c.in.get<std::uint32_t>();
+                if (n > max_elements) throw std::runtime_error("too many elements");
+
+                c.storage.clear();
+                c.index_at.clear();
+                std::vector<std::size_t> offsets;
+                for (std::uint32_t i = 0; i < n; ++i)
+                {
+                    offsets.push_back(std::size(c.storage));
+                    c.storage += c.in.get_string(c.in.get<std::uint32_t>());
+                    c.index_at.resize(std::size(c.storage) + 1, static_cast<std::uint8_t>(i));
+                    c.storage.push_back('\0');
+                }
+                c.elems.clear();
+                for (std::uint32_t i = 0; i < n; ++i)
+                {
+                    const auto end = (i + 1 < n ? offsets[i + 1] : std::size(c.storage)) - 1;
+                    c.elems.emplace_back(std::data(c.storage) + offsets[i], end - offsets[i]);
+                }
+
+                c.count = 0;
+                c.count_only = flags & flag_count_only;
+                c.batch.clear();
+                c.batch_perms = 0;
+                try
+                {
+                    const auto &engine = [&]() -> const registry::engine & {
+                        if (algorithm != "auto") return registry::get_engine(algorithm);
+                        registry::requirements req;
+                        req.n = n;
+                        req.range = range.has_value();
+                        const auto mode = c.count_only ? autotune::mode_count : autotune::mode_print;
+                        if (const auto choice = prof ? autotune::choose(*prof, mode, req) : std::nullopt) return *choice->engine;
+                        return registry::select_engine(req);
+                    }();
+                    if (range)
+                    {
+                        if (!engine.properties.supports_range) throw std::domain_error("algorithm " + engine.name + " does not support a rank range");
+                        const auto total = permutation_rank::factorial(n);
+                        if (range->first > range->second || range->second > total) throw std::out_of_range("rank range out of range");
+                        engine.perm_range(std::cbegin(c.elems), std::cend(c.elems), range->first, range->second, connection::each_perm, &c);
+                    }
+                    else
+                    {
+                        engine.perm_all(std::cbegin(c.elems), std::cend(c.elems), connection::each_perm, &c);
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    c.batch.clear();
+                    c.batch_perms = 0;
+                    const std::string what = e.what();
+                    c.out.put('X');
+                    c.out.put(static_cast<std::uint32_t>(std::size(what)));
+                    c.out.put_bytes(std::data(what), std::size(what));
+                    c.out.flush();
+                    return true;
+                }
+                c.flush_batch();
+                c.out.put('E');
+                c.out.put(static_cast<std::uint64_t>(c.count));
+                c.out.flush();
+                return true;
+            }
+        }
+
+        // Listens on a Unix domain socket and serves connections on a pool of threads.
+        class server
+        {
+        public:
+            // Bind and listen on path, replacing a stale socket file there.
+            // prof: the autotune profile "auto" jobs consult, if any.
+            server(const std::filesystem::path &path, const unsigned int threads, std::optional<autotune::profile> prof = std::nullopt)
+                : path_(path), threads_(std::max(1u, threads)), profile_(std::move(prof))
+            {
+                const auto addr = detail::make_address(path_);
+                listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (listen_fd_ < 0) detail::throw_errno("socket");
+                std::filesystem::remove(path_);
+                if (::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd_, SOMAXCONN) < 0)
+                {
+                    const auto e = errno;
+                    ::close(listen_fd_);
+                    throw std::system_error(e, std::generic_category(), "bind " + path_.string());
+                }
+            }
+            server(const server &) = delete;
+            server &operator=(const server &) = delete;
+            ~server()
+            {
+                stop();
+                ::close(listen_fd_);
+                std::error_code ec;
+                std::filesystem::remove(path_, ec);
+            }
+
+            // Accept and serve connections until stop() is called.
+            void run()
+            {
+                std::vector<std::thread> workers;
+                for (unsigned int i = 0; i < threads_; ++i) workers.emplace_back([this] { work(); });
+                while (!stopping_)
+                {
+                    const auto fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+                    if (fd < 0)
+                    {
+                        if (errno == EINTR || errno == ECONNABORTED) continue;
+                        break;  // stop() shut the socket down
+                    }
+                    std::lock_guard lock(mutex_);
+                    if (stopping_)
+                    {
+                        ::close(fd);
+                        break;
+                    }
+                    pending_.push_back(fd);
+                    active_.insert(fd);
+                    cv_.notify_one();
+                }
+                {
+                    std::lock_guard lock(mutex_);
+                    stopping_ = true;
+                }
+                cv_.notify_all();
+                for (auto &t : workers) t.join();
+            }
+
+            // Make run() return after closing all connections. Thread-safe.
+            void stop()
+            {
+                std::lock_guard lock(mutex_);
+                stopping_ = true;
+                ::shutdown(listen_fd_, SHUT_RDWR);
+                for (const auto fd : active_) ::shutdown(fd, SHUT_RDWR);
+                cv_.notify_all();
+            }
+
+        private:
+            void work()
+            {
+                for (;;)
+                {
+                    int fd;
+                    {
+                        std::unique_lock lock(mutex_);
+                        cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+                        if (pending_.empty()) return;
+                        fd = pending_.front();
+                        pending_.pop_front();
+                    }
+                    try
+                    {
+                        detail::connection c(fd);
+                        c.stopping = &stopping_;
+                        while (detail::serve_job(c, profile_ ? &*profile_ : nullptr)) {}
+                    }
+                    catch (const std::exception &)
+                    {
+                        // A broken connection only ends itself.
+                    }
+                    std::lock_guard lock(mutex_);
+                    active_.erase(fd);
+                    ::close(fd);
+                }
+            }
+
+            std::filesystem::path path_;
+            unsigned int threads_;
+            std::optional<autotune::profile> profile_;
+            int listen_fd_ = -1;
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            std::deque<int> pending_;
+            std::set<int> active_;
+            std::atomic<bool> stopping_ = false;
+        };
+
+        // A connection to a server.
+        class client
+        {
+        public:
+            explicit client(const std::filesystem::path &path)
+            {
+                const auto addr = detail::make_address(path);
+                fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (fd_ < 0) detail::throw_errno("socket");
+                if (::connect(fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0)
+                {
+                    const auto e = errno;
+                    ::close(fd_);
+                    throw std::system_error(e, std::generic_category(), "connect " + path.string());
+                }
+                in_.emplace(fd_);
+                out_.emplace(fd_);
+            }
+            client(const client &) = delete;
+            client &operator=(const client &) = delete;
+            ~client() { ::close(fd_); }
+
+            // Run job on the server, calling on_perm with the element indices of each
+            // permutation unless job.count_only. Return the number of permutations.
+            // Throws std::runtime_error with the server's message if the job failed.
+            int64_t run(const job_request &job, const std::function<void(std::span<const std::uint8_t>)> &on_perm = {})
+            {
+                if (std::size(job.elements) > max_elements) throw std::invalid_argument("too many elements");
+                if (std::size(job.algorithm) > 255) throw std::invalid_argument("algorithm name too long");
+                auto &out = *out_;
+                out.put('J');
+                out.put(static_cast<std::uint8_t>((job.count_only ? flag_count_only : 0) | (job.range ? flag_range : 0)));
+                out.put(static_cast<std::uint8_t>(std::size(job.algorithm)));
+                out.put_bytes(std::data(job.algorithm), std::size(job.algorithm));
+                if (job.range)
+                {
+                    out.put(static_cast<std::uint64_t>(job.range->first));
+                    out.put(static_cast<std::uint64_t>(job.range->second));
+                }
+                out.put(static_cast<std::uint32_t>(std::size(job.elements)));
+                for (const auto &e : job.elements)
+                {
+                    out.put(static_cast<std::uint32_t>(std::size(e)));
+                    out.put_bytes(std::data(e), std::size(e));
+                }
+                out.flush();
+
+                auto &in = *in_;
+                const auto n = std::size(job.elements);
+                std::vector<std::uint8_t> batch;
+                for (;;)
+                {
+                    switch (in.get<char>())
+                    {
+                    case 'P':
+                    {
+                        const auto k = in.get<std::uint32_t>();
+                        batch.resize(std::size_t{k} * n);
+                        if (!batch.empty() && !in.read(std::data(batch), std::size(batch))) throw std::runtime_error("connection closed");
+                        for (std::size_t i = 0; on_perm && i < k; ++i) on_perm(std::span(std::data(batch) + i * n, n));
+                        break;
+                    }
+                    case 'E':
+                        return static_cast<int64_t>(in.get<std::uint64_t>());
+                    case 'X':
+                        throw std::runtime_error(in.get_string(in.get<std::uint32_t>()));
+                    default:
+                        throw std::runtime_error("bad reply frame");
+                    }
+                }
+            }
+
+        private:
+            int fd_ = -1;
+            std::optional<detail::reader> in_;
+            std::optional<detail::writer> out_;
+        };
+    }
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "permutation.h"
+#include "permutation_checksum.h"
+#include "permutation_parallel.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    namespace shard
+    {
+        // Identifies the elements of a problem, so that shards of different problems are not mixed.
+        inline std::uint64_t elements_hash(const perm_iterator_type first, const perm_iterator_type last)
+        {
+            auto h = checksum::fnv1a_offset;
+            for (auto it = first; it != last; ++it)
+            {
+                h = checksum::fnv1a(*it, h);
+                h = checksum::fnv1a(std::string_view("\0", 1), h);
+            }
+            return h;
+        }
+
+        // Shard index of count shards, 0 <= index < count.
+        struct shard_spec
+        {
+            rank_type index;
+            rank_type count;
+        };
+
+        // Parse "i/N". Throws std::invalid_argument.
+        inline shard_spec parse_shard(const std::string_view s)
+        {
+            shard_spec r{};
+            const auto slash = s.find('/');
+            const auto end = s.data() + std::size(s);
+            if (slash == std::string_view::npos
+                || std::from_chars(s.data(), s.data() + slash, r.index).ptr != s.data() + slash
+                || std::from_chars(s.data() + slash + 1, end, r.count).ptr != end
+                || r.count == 0 || r.index >= r.count)
+            {
+                throw std::invalid_argument("bad shard " + std::string(s) + "; expected i/N with 0 <= i < N");
+            }
+            return r;
+        }
+
+        // Ranks [first:last) of shard s of total permutations. Shard sizes differ by at most one.
+        inline std::pair<rank_type, rank_type> shard_range(const rank_type total, const shard_spec s)
+        {
+            return {permutation_parallel::chunk_begin(total, s.count, s.index), permutation_parallel::chunk_begin(total, s.count, s.index + 1)};
+        }
+
+        // What a shard run covered, written next to its output.
+        struct manifest
+        {
+            std::string algorithm;
+            std::string order;
+            std::size_t n = 0;
+            std::uint64_t elements_hash = 0;
+            shard_spec shard{0, 1};
+            rank_type rank_first = 0;
+            rank_type rank_last = 0;
+            rank_type count = 0;            // Permutations actually generated.
+            checksum::digest digest;        // Checksum of the permutations generated.
+            std::uint64_t output_hash = 0;  // FNV-1a of the output bytes as written.
+            std::string output;             // Output file, or empty for stdout.
+        };
+
+        // The manifest is a text file of "key value" lines.
+        inline void write_manifest(std::ostream &os, const manifest &m)
+        {
+            os << "# permutation shard manifest\n"
+                << "algorithm " << m.algorithm << "\n"
+                << "order " << m.order << "\n"
+                << "n " << m.n << "\n"
+                << "elements_hash " << m.elements_hash << "\n"
+                << "shard " << m.shard.index << "/" << m.shard.count << "\n"
+                << "rank_first " << m.rank_first << "\n"
+                << "rank_last " << m.rank_last << "\n"
+                << "count " << m.count << "\n"
+                << "checksum " << checksum::to_string(m.digest) << "\n"
+                << "output_hash " << m.output_hash << "\n";
+            if (!m.output.empty()) os << "output " << m.output << "\n";
+        }
+
+        // Throws std::runtime_error on a malformed manifest.
+        inline manifest read_manifest(std::istream &is)
+        {
+            manifest m;
+            std::string line;
+            unsigned int seen = 0;
+            for (int lineno = 1; std::getline(is, line); ++lineno)
+            {
+                std::istringstream ls(line);
+                std::string key;
+                if (!(ls >> key) || key[0] == '#') continue;
+                std::string value;
+                std::getline(ls >> std::ws, value);
+                auto number = [&](auto &dest) {
+                    if (std::from_chars(value.data(), value.data() + std::size(value), dest).ptr != value.data() + std::size(value))
+                    {
+                        throw std::runtime_error("bad " + key + " in manifest line " + std::to_string(lineno));
+                    }
+                };
+                if (key == "algorithm") m.algorithm = value;
+                else if (key == "order") m.order = value;
+                else if (key == "n") number(m.n);
+                else if (key == "elements_hash") number(m.elements_hash);
+                else if (key == "shard") m.shard = parse_shard(value);
+                else if (key == "rank_first") number(m.rank_first);
+                else if (key == "rank_last") number(m.rank_last);
+                else if (key == "count") number(m.count);
+                else if (key == "checksum")
+                {
+                    try
+                    {
+                        m.digest = checksum::parse_digest(value);
+                    }
+                    catch (const std::invalid_argument &)
+                    {
+                        throw std::runtime_error("bad checksum in manifest line " + std::to_string(lineno));
+                    }
+                }
+                else if (key == "output_hash") number(m.output_hash);
+                else if (key == "output") m.output = value;
+                else throw std::runtime_error("unknown key " + key + " in manifest line " + std::to_string(lineno));
+                ++seen;
+            }
+            if (seen < 10) throw std::runtime_error("incomplete manifest");
+            return m;
+        }
+
+        inline void save_manifest(const std::filesystem::path &path, const manifest &m)
+        {
+            std::ofstream os(path);
+            write_manifest(os, m);
+            if (!os.flush()) throw std::runtime_error("cannot write manifest " + path.string());
+        }
+
+        inline manifest load_manifest(const std::filesystem::path &path)
+        {
+            std::ifstream is(path);
+            if (!is) throw std::runtime_error("cannot open manifest " + path.string());
+            try
+            {
+                return read_manifest(is);
+            }
+            catch (const std::runtime_error &e)
+            {
+                throw std::runtime_error(path.string() + ": " + e.what());
+            }
+        }
+
+        // Check that manifests are shards of one problem that together cover every rank
+        // of [0:n!) exactly once, and sort them by rank. Return n! and the checksum of
+        // the whole enumeration.
+        // Throws std::runtime_error describing the first problem found.
+        inline std::pair<rank_type, checksum::digest> verify(std::vector<manifest> &manifests)
+        {
+            if (manifests.empty()) throw std::runtime_error("no shards");
+            const auto &m0 = manifests.front();
+            for (const auto &m : manifests)
+            {
+                if (m.algorithm != m0.algorithm || m.order != m0.order || m.n != m0.n || m.elements_hash != m0.elements_hash)
+                {
+                    throw std::runtime_error("shards " + std::to_string(m0.shard.index) + " and " + std::to_string(m.shard.index) + " are of different problems");
+                }
+                if (m.rank_first > m.rank_last || m.count != m.rank_last - m.rank_first)
+                {
+                    throw std::runtime_error("shard " + std::to_string(m.shard.index) + " generated " + std::to_string(m.count)
+                        + " permutations for ranks [" + std::to_string(m.rank_first) + ":" + std::to_string(m.rank_last) + ")");
+                }
+            }
+
+            std::sort(std::begin(manifests), std::end(manifests), [](const auto &a, const auto &b) {
+                return std::pair(a.rank_first, a.rank_last) < std::pair(b.rank_first, b.rank_last);
+            });
+            const auto total = permutation_rank::factorial(static_cast<unsigned int>(m0.n));
+            rank_type covered = 0;
+            checksum::digest sum;
+            for (const auto &m : manifests)
+            {
+                sum += m.digest;
+                if (m.rank_first > covered) throw std::runtime_error("ranks [" + std::to_string(covered) + ":" + std::to_string(m.rank_first) + ") are missing");
+                if (m.rank_first < covered) throw std::runtime_error("ranks [" + std::to_string(m.rank_first) + ":" + std::to_string(covered) + ") are covered twice");
+                covered = m.rank_last;
+            }
+            if (covered != total) throw std::runtime_error("ranks [" + std::to_string(covered) + ":" + std::to_string(total) + ") are missing");
+            return {total, sum};
+        }
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <sys/mman.h>
+#include "permutation.h"
+#include "permutation_rank.h"
+#include "permutation_registry.h"
+
+namespace permutation_algorithms
+{
+    // Storage for materialized permutations. perm_all_container() allocates a vector per
+    // permutation; flat_perms packs them back to back in one mapping backed by huge pages,
+    // so that filling and scanning n! permutations needs a TLB entry per 2 MB, not per 4 KB.
+    namespace storage
+    {
+        constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+        enum class page_policy
+        {
+            normal,         // 4 KB pages, transparent huge pages refused
+            transparent,    // madvise(MADV_HUGEPAGE), left to the kernel
+            hugetlb,        // MAP_HUGETLB from the reserved pool, else transparent
+        };
+
+        inline std::string_view to_string(const page_policy policy)
+        {
+            switch (policy)
+            {
+            case page_policy::normal: return "normal";
+            case page_policy::transparent: return "transparent";
+            case page_policy::hugetlb: return "hugetlb";
+            }
+            return "unknown";
+        }
+
+        // Anonymous zeroed memory, a multiple of huge_page_size long and aligned to it.
+        // Move-only; unmapped on destruction. Throws std::length_error for a size that
+        // cannot be rounded up and aligned.
+        class huge_buffer
+        {
+        public:
+            huge_buffer() = default;
+            explicit huge_buffer(const std::size_t size, const page_policy policy = page_policy::transparent)
+            {
+                if (size == 0) return;
+                if (size > std::numeric_limits<std::size_t>::max() - 2 * huge_page_size) throw std::length_error("huge_buffer too large");
+                length_ = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+                if (policy == page_policy::hugetlb)
+                {
+                    const auto p = ::mmap(nullptr, length_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                    if (p != MAP_FAILED)
+                    {
+                        data_ = p;
+                        policy_ = page_policy::hugetlb;
+                        return;
+                    }
+                }
+                // Map a huge page more than needed and trim both ends to align.
+                const auto total = length_ + huge_page_size;
+                const auto p = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "mmap");
+                const auto base = reinterpret_cast<std::uintptr_t>(p);
+                const auto aligned = (base + huge_page_size - 1) / huge_page_size * huge_page_size;
+                if (aligned > base) ::munmap(p, aligned - base);
+                if (const auto tail = base + total - (aligned + length_); tail > 0) ::munmap(reinterpret_cast<void *>(aligned + length_), tail);
+                data_ = reinterpret_cast<void *>(aligned);
+                policy_ = policy == page_policy::normal ? page_policy::normal : page_policy::transparent;
+                ::madvise(data_, length_, policy_ == page_policy::normal ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+            }
+            huge_buffer(huge_buffer &&other) noexcept { swap(other); }
+            huge_buffer &operator=(huge_buffer &&other) noexcept
+            {
+                huge_buffer(std::move(other)).swap(*this);
+                return *this;
+            }
+            ~huge_buffer() { if (data_) ::munmap(data_, length_); }
+
+            void swap(huge_buffer &other) noexcept
+            {
+                std::swap(data_, other.data_);
+                std::swap(length_, other.length_);
+                std::swap(policy_, other.policy_);
+            }
+
+            void *data() const { return data_; }
+            std::size_t size() const { return length_; }
+            // The policy obtained: hugetlb falls back to transparent without a reserved pool.
+            page_policy policy() const { return policy_; }
+
+        private:
+            void *data_ = nullptr;
+            std::size_t length_ = 0;
+            page_policy policy_ = page_policy::normal;
+        };
+
+        // Up to capacity permutations of n elements, stored as rows of n elements in a
+        // huge_buffer. Throws std::length_error if n * capacity elements overflow size_t.
+        class flat_perms
+        {
+        public:
+            flat_perms() = default;
+            flat_perms(const std::size_t n, const std::size_t capacity, const page_policy policy = page_policy::transparent)
+                : buffer_(bytes(n, capacity), policy), rows_(static_cast<elem_type *>(buffer_.data())), n_(n), capacity_(capacity)
+            {
+            }
+
+            // Throws std::length_error when full, std::invalid_argument for a row of another size.
+            void push_back(const perm_iterator_type first, const perm_iterator_type last)
+            {
+                if (size_ == capacity_) throw std::length_error("flat_perms is full");
+                if (static_cast<std::size_t>(std::distance(first, last)) != n_) throw std::invalid_argument("permutation of another size");
+                auto *row = rows_ + size_ * n_;
+                for (auto it = first; it != last; ++it) ::new (static_cast<void *>(row++)) elem_type(*it);
+                ++size_;
+            }
+
+            std::span<const elem_type> operator[](const std::size_t i) const { return {rows_ + i * n_, n_}; }
+            std::size_t size() const { return size_; }
+            std::size_t capacity() const { return capacity_; }
+            std::size_t n() const { return n_; }
+            page_policy policy() const { return buffer_.policy(); }
+
+        private:
+            static std::size_t bytes(const std::size_t n, const std::size_t capacity)
+            {
+                if (n != 0 && capacity > std::numeric_limits<std::size_t>::max() / sizeof(elem_type) / n) throw std::length_error("flat_perms too large");
+                return n * capacity * sizeof(elem_type);
+            }
+
+            huge_buffer buffer_;
+            elem_type *rows_ = nullptr;
+            std::size_t n_ = 0;
+            std::size_t capacity_ = 0;
+            std::size_t size_ = 0;
+        };
+
+        // All permutations of [first:last) that perm_all generates, flat. Throws
+        // std::domain_error for more than permutation_rank::max_rank_n elements.
+        inline flat_perms materialize(const perm_all_function_type &perm_all, const perm_iterator_type first, const perm_iterator_type last,
+            const page_policy policy = page_policy::transparent)
+        {
+            const auto n = static_cast<std::size_t>(std::distance(first, last));
+            if (n > permutation_rank::max_rank_n) throw std::domain_error("too many elements to materialize");
+            flat_perms r(n, permutation_rank::factorial(static_cast<unsigned int>(n)), policy);
+            perm_all(first, last, [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) { r.push_back(f, l); }, {});
+            return r;
+        }
+    }
+}
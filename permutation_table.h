@@ -0,0 +1,437 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "permutation.h"
+#include "permutation_checksum.h"
+#include "permutation_rank.h"
+#include "permutation_registry.h"
+
+// Tables of all index permutations of n elements in an engine order, as files or
+// shared memory objects mapped into memory. A row holds one permutation as n one-byte indices into the elements the
+// engine starts from, so a table serves every set of n elements; rows are in rank order.
+//
+// File layout, in the host's byte order:
+//   char[8] "PERMTBL1", u32 n, u32 order, u64 rows, u64 checksum, zeros up to byte 64
+//   rows * n bytes of indices, zeros up to a multiple of 8 bytes
+namespace permutation_algorithms
+{
+    namespace table
+    {
+        // 12! rows of 12 bytes are 5.7 GB.
+        constexpr unsigned int max_table_n = 12;
+        constexpr std::size_t header_size = 64;
+
+        namespace detail
+        {
+            constexpr char magic[8] = {'P', 'E', 'R', 'M', 'T', 'B', 'L', '1'};
+
+            struct file_header
+            {
+                char magic[8];
+                std::uint32_t n;
+                std::uint32_t order;
+                std::uint64_t rows;
+                std::uint64_t checksum;
+                std::uint8_t padding[header_size - 32];
+            };
+            static_assert(sizeof(file_header) == header_size);
+
+            [[noreturn]] inline void throw_errno(const std::string &what)
+            {
+                throw std::system_error(errno, std::generic_category(), what);
+            }
+
+            class file_descriptor
+            {
+            public:
+                explicit file_descriptor(const int fd) : fd_(fd) {}
+                file_descriptor(const file_descriptor &) = delete;
+                file_descriptor &operator=(const file_descriptor &) = delete;
+                ~file_descriptor() { if (fd_ >= 0) ::close(fd_); }
+                int get() const { return fd_; }
+
+            private:
+                int fd_;
+            };
+
+            inline std::size_t payload_size(const unsigned int n, const rank_type rows)
+            {
+                return (static_cast<std::size_t>(rows) * n + 7) / 8 * 8;
+            }
+
+            // FNV-1a over 64-bit words rather than bytes, finished by checksum::mix: a
+            // gigabyte is checked in a fraction of a second. size is a multiple of 8.
+            inline std::uint64_t payload_checksum(const std::uint8_t *p, const std::size_t size)
+            {
+                auto h = checksum::fnv1a_offset;
+                for (std::size_t i = 0; i < size; i += 8)
+                {
+                    std::uint64_t w;
+                    std::memcpy(&w, p + i, sizeof(w));
+                    h = (h ^ w) * checksum::fnv1a_prime;
+                }
+                return checksum::mix(h);
+            }
+
+            inline void check_n(const unsigned int n)
+            {
+                if (n > max_table_n) throw std::domain_error("no table of " + std::to_string(n) + " elements");
+            }
+        }
+
+        // The rows of the table of n elements in order, generated by the fastest engine of
+        // that order, written to dest.
+        inline void generate(const unsigned int n, const registry::perm_order order, std::uint8_t *dest)
+        {
+            detail::check_n(n);
+            static const char indices[max_table_n] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+            perm_type elems;
+            for (unsigned int i = 0; i < n; ++i) elems.emplace_back(&indices[i], 1);
+            registry::requirements req;
+            req.n = n;
+            req.order = order;
+            registry::select_engine(req).perm_all(std::cbegin(elems), std::cend(elems),
+                [&](const perm_iterator_type first, const perm_iterator_type last, const std::any &) {
+                    for (auto it = first; it != last; ++it) *dest++ = static_cast<std::uint8_t>(it->data() - indices);
+                },
+                {});
+        }
+
+        // A table file mapped read-only. Move-only; unmapped on destruction.
+        class mapped_table
+        {
+        public:
+            mapped_table() = default;
+            mapped_table(void *map, const std::size_t length) : map_(map), length_(length)
+            {
+                std::memcpy(&header_, map, sizeof(header_));
+            }
+            mapped_table(mapped_table &&other) noexcept { swap(other); }
+            mapped_table &operator=(mapped_table &&other) noexcept
+            {
+                mapped_table(std::move(other)).swap(*this);
+                return *this;
+            }
+            ~mapped_table() { if (map_) ::munmap(map_, length_); }
+
+            void swap(mapped_table &other) noexcept
+            {
+                std::swap(map_, other.map_);
+                std::swap(length_, other.length_);
+                std::swap(header_, other.header_);
+            }
+
+            unsigned int n() const { return header_.n; }
+            registry::perm_order order() const { return static_cast<registry::perm_order>(header_.order); }
+            rank_type size() const { return header_.rows; }
+            const std::uint8_t *data() const { return static_cast<const std::uint8_t *>(map_) + header_size; }
+
+            // The indices of the permutation of rank r.
+            std::span<const std::uint8_t> operator[](const rank_type r) const
+            {
+                return {data() + static_cast<std::size_t>(r) * n(), n()};
+            }
+
+            // The permutations of [first:last) of rank [rank_first:rank_last), with the
+            // signature of an engine's perm_range. Lexicographic rows index the sorted
+            // elements, which must then be distinct to match permutation_std; throws
+            // std::invalid_argument if they are not.
+            void perm_range(const perm_iterator_type first, const perm_iterator_type last, const rank_type rank_first, const rank_type rank_last,
+                output_each_perm_function_type output_each_perm, const std::any &user_data) const
+            {
+                if (static_cast<std::size_t>(std::distance(first, last)) != n()) throw std::invalid_argument("table of another number of elements");
+                if (rank_first >= rank_last) return;
+                if (rank_last > size()) throw std::out_of_range("rank out of range");
+                perm_type base(first, last);
+                if (order() == registry::perm_order::lexicographic)
+                {
+                    std::sort(std::begin(base), std::end(base));
+                    if (std::adjacent_find(std::cbegin(base), std::cend(base)) != std::cend(base)) throw std::invalid_argument("elements are not distinct");
+                }
+                perm_type a(n());
+                for (auto r = rank_first; r < rank_last; ++r)
+                {
+                    const auto *row = data() + static_cast<std::size_t>(r) * n();
+                    for (unsigned int k = 0; k < n(); ++k) a[k] = base[row[k]];
+                    output_each_perm(std::cbegin(a), std::cend(a), user_data);
+                }
+            }
+
+            void perm_all(const perm_iterator_type first, const perm_iterator_type last, output_each_perm_function_type output_each_perm, const std::any &user_data) const
+            {
+                perm_range(first, last, 0, size(), std::move(output_each_perm), user_data);
+            }
+
+        private:
+            void *map_ = nullptr;
+            std::size_t length_ = 0;
+            detail::file_header header_{};
+        };
+
+        namespace detail
+        {
+            inline std::size_t table_length(const unsigned int n)
+            {
+                return header_size + payload_size(n, permutation_rank::factorial(n));
+            }
+
+            // Generate the table of n elements in order into p, table_length(n) zeroed
+            // bytes. The magic is stored last, with release semantics, so that another
+            // process mapping p sees a complete table once it sees the magic.
+            inline void fill(std::uint8_t *p, const unsigned int n, const registry::perm_order order)
+            {
+                generate(n, order, p + header_size);
+                file_header h{};
+                h.n = n;
+                h.order = static_cast<std::uint32_t>(order);
+                h.rows = permutation_rank::factorial(n);
+                h.checksum = payload_checksum(p + header_size, table_length(n) - header_size);
+                std::memcpy(p, &h, sizeof(h));
+                std::uint64_t m;
+                std::memcpy(&m, magic, sizeof(m));
+                __atomic_store_n(reinterpret_cast<std::uint64_t *>(p), m, __ATOMIC_RELEASE);
+            }
+
+            inline bool has_magic(const void *map)
+            {
+                std::uint64_t m;
+                std::memcpy(&m, magic, sizeof(m));
+                return __atomic_load_n(static_cast<const std::uint64_t *>(map), __ATOMIC_ACQUIRE) == m;
+            }
+
+            // Throw std::runtime_error unless map holds a valid table of length bytes.
+            inline void check_table(const void *map, const std::size_t length, const bool verify, const std::string &what)
+            {
+                file_header h;
+                std::memcpy(&h, map, sizeof(h));
+                if (!has_magic(map) || h.n > max_table_n || h.order > static_cast<std::uint32_t>(registry::perm_order::heap)
+                    || h.rows != permutation_rank::factorial(h.n) || length != table_length(h.n))
+                {
+                    throw std::runtime_error("not a permutation table: " + what);
+                }
+                if (verify)
+                {
+                    const auto *p = static_cast<const std::uint8_t *>(map);
+                    ::madvise(const_cast<void *>(map), length, MADV_SEQUENTIAL);
+                    if (payload_checksum(p + header_size, length - header_size) != h.checksum) throw std::runtime_error("corrupt permutation table: " + what);
+                    ::madvise(const_cast<void *>(map), length, MADV_NORMAL);
+                }
+            }
+        }
+
+        // Generate the table of n elements in order into path, through a temporary file
+        // renamed over path, so that readers never see a partial table.
+        inline void write_table(const std::filesystem::path &path, const unsigned int n, const registry::perm_order order)
+        {
+            detail::check_n(n);
+            const auto length = detail::table_length(n);
+            auto tmp = path;
+            tmp += ".tmp." + std::to_string(::getpid());
+            {
+                detail::file_descriptor fd(::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+                if (fd.get() < 0) detail::throw_errno("open " + tmp.string());
+                if (::ftruncate(fd.get(), static_cast<off_t>(length)) != 0) detail::throw_errno("ftruncate " + tmp.string());
+                const auto map = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+                if (map == MAP_FAILED) detail::throw_errno("mmap " + tmp.string());
+                try
+                {
+                    detail::fill(static_cast<std::uint8_t *>(map), n, order);
+                }
+                catch (...)
+                {
+                    ::munmap(map, length);
+                    std::filesystem::remove(tmp);
+                    throw;
+                }
+                ::munmap(map, length);
+            }
+            std::filesystem::rename(tmp, path);
+        }
+
+        // Map the table at path. With verify, its checksum is checked, which reads it all.
+        // Throws std::system_error if it cannot be mapped, std::runtime_error if it is not
+        // a valid table.
+        inline mapped_table open_table(const std::filesystem::path &path, const bool verify = true)
+        {
+            detail::file_descriptor fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+            if (fd.get() < 0) detail::throw_errno("open " + path.string());
+            struct stat st;
+            if (::fstat(fd.get(), &st) != 0) detail::throw_errno("fstat " + path.string());
+            const auto length = static_cast<std::size_t>(st.st_size);
+            if (length < header_size) throw std::runtime_error("not a permutation table: " + path.string());
+            const auto map = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd.get(), 0);
+            if (map == MAP_FAILED) detail::throw_errno("mmap " + path.string());
+            mapped_table t(map, length);
+            detail::check_table(map, length, verify, path.string());
+            return t;
+        }
+
+        // The cache directory: $PERMUTATION_TABLE_CACHE, else permutation under
+        // $XDG_CACHE_HOME or ~/.cache.
+        inline std::filesystem::path default_cache_dir()
+        {
+            if (const auto p = std::getenv("PERMUTATION_TABLE_CACHE"); p && *p) return p;
+            if (const auto p = std::getenv("XDG_CACHE_HOME"); p && *p) return std::filesystem::path(p) / "permutation";
+            if (const auto p = std::getenv("HOME"); p && *p) return std::filesystem::path(p) / ".cache" / "permutation";
+            return "permutation.cache";
+        }
+
+        inline std::filesystem::path cache_path(const std::filesystem::path &dir, const unsigned int n, const registry::perm_order order)
+        {
+            return dir / (std::string(registry::to_string(order)) + "-" + std::to_string(n) + ".ptbl");
+        }
+
+        // Map the table of n elements in order from the cache in dir, generating it first
+        // if it is missing or invalid. Processes may load the same table concurrently.
+        // Only the header and length are checked unless verify, which reads the whole
+        // table to check its checksum and regenerates it on a mismatch.
+        inline mapped_table load(const unsigned int n, const registry::perm_order order, const std::filesystem::path &dir = default_cache_dir(), const bool verify = false)
+        {
+            detail::check_n(n);
+            const auto path = cache_path(dir, n, order);
+            try
+            {
+                auto t = open_table(path, verify);
+                if (t.n() == n && t.order() == order) return t;
+            }
+            catch (const std::system_error &e)
+            {
+                if (e.code() != std::errc::no_such_file_or_directory) throw;
+            }
+            catch (const std::runtime_error &)
+            {
+                // Invalid; regenerate.
+            }
+            std::filesystem::create_directories(dir);
+            write_table(path, n, order);
+            return open_table(path, false);
+        }
+
+        // Tables in POSIX shared memory, so that the processes of a host map one copy.
+        // Mappings ask for transparent huge pages, which shared memory gets when
+        // /sys/kernel/mm/transparent_hugepage/shmem_enabled is advise or always.
+
+        inline std::string shm_name(const unsigned int n, const registry::perm_order order)
+        {
+            return "/permutation-" + std::string(registry::to_string(order)) + "-" + std::to_string(n);
+        }
+
+        namespace detail
+        {
+            inline void advise_huge_pages(void *map, const std::size_t length)
+            {
+#ifdef MADV_HUGEPAGE
+                ::madvise(map, length, MADV_HUGEPAGE);
+#endif
+            }
+        }
+
+        // Map the table published as name, waiting up to timeout for the process
+        // publishing it to finish. Throws std::system_error if there is none,
+        // std::runtime_error if it is invalid or still unfinished after timeout.
+        inline mapped_table attach(const std::string &name, const std::chrono::milliseconds timeout = std::chrono::seconds(60))
+        {
+            detail::file_descriptor fd(::shm_open(name.c_str(), O_RDONLY, 0));
+            if (fd.get() < 0) detail::throw_errno("shm_open " + name);
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            auto wait = [&] {
+                if (std::chrono::steady_clock::now() >= deadline) throw std::runtime_error("permutation table " + name + " is unfinished");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            };
+            // The publisher sizes the object once, then fills it.
+            std::size_t length = 0;
+            for (;;)
+            {
+                struct stat st;
+                if (::fstat(fd.get(), &st) != 0) detail::throw_errno("fstat " + name);
+                length = static_cast<std::size_t>(st.st_size);
+                if (length >= header_size) break;
+                wait();
+            }
+            const auto map = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd.get(), 0);
+            if (map == MAP_FAILED) detail::throw_errno("mmap " + name);
+            try
+            {
+                while (!detail::has_magic(map)) wait();
+            }
+            catch (...)
+            {
+                ::munmap(map, length);
+                throw;
+            }
+            detail::advise_huge_pages(map, length);
+            mapped_table t(map, length);
+            detail::check_table(map, length, false, name);
+            return t;
+        }
+
+        // Generate the table of n elements in order into the shared memory object name and
+        // map it, or map the one another process has published or is publishing. The object
+        // outlives the processes until unpublish().
+        inline mapped_table publish(const unsigned int n, const registry::perm_order order, const std::string &name)
+        {
+            detail::check_n(n);
+            detail::file_descriptor fd(::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644));
+            if (fd.get() < 0)
+            {
+                if (errno != EEXIST) detail::throw_errno("shm_open " + name);
+                auto t = attach(name);
+                if (t.n() != n || t.order() != order) throw std::runtime_error(name + " holds another permutation table");
+                return t;
+            }
+            const auto length = detail::table_length(n);
+            try
+            {
+                if (::ftruncate(fd.get(), static_cast<off_t>(length)) != 0) detail::throw_errno("ftruncate " + name);
+                const auto map = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+                if (map == MAP_FAILED) detail::throw_errno("mmap " + name);
+                mapped_table t;
+                try
+                {
+                    detail::advise_huge_pages(map, length);
+                    detail::fill(static_cast<std::uint8_t *>(map), n, order);
+                    t = mapped_table(map, length);
+                }
+                catch (...)
+                {
+                    ::munmap(map, length);
+                    throw;
+                }
+                return t;
+            }
+            catch (...)
+            {
+                ::shm_unlink(name.c_str());
+                throw;
+            }
+        }
+
+        inline mapped_table publish(const unsigned int n, const registry::perm_order order)
+        {
+            return publish(n, order, shm_name(n, order));
+        }
+
+        // Remove the shared memory object name; processes mapping it keep their mappings.
+        inline void unpublish(const std::string &name)
+        {
+            if (::shm_unlink(name.c_str()) != 0 && errno != ENOENT) detail::throw_errno("shm_unlink " + name);
+        }
+    }
+}
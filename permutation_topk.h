@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <any>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "permutation.h"
+
+namespace permutation_algorithms
+{
+    namespace topk
+    {
+        template <typename TScore>
+        struct entry
+        {
+            TScore score;
+            perm_type perm;
+        };
+
+        // Keeps the k permutations of lowest score, without materializing the others;
+        // negate the score to keep the highest. Each thread of an enumeration fills its
+        // own bounded heap through the user data from worker_data(); results() merges
+        // them. The worst score of a full heap bounds the k-th best overall, so it is
+        // shared through an atomic threshold and permutations scoring worse are rejected
+        // before touching any heap.
+        // TScore must be a lock-free atomic type, such as double or an integer.
+        template <typename TScore = double>
+        class collector
+        {
+        public:
+            using entry_type = entry<TScore>;
+            using score_function_type = std::function<TScore(const perm_iterator_type, const perm_iterator_type)>;
+
+            collector(const std::size_t k, score_function_type score, const unsigned int workers = 1)
+                : k_(k), score_(std::move(score)), locals_(std::max(1u, workers))
+            {
+                for (auto &l : locals_) l = std::make_unique<local>(this);
+            }
+            collector(const collector &) = delete;
+            collector &operator=(const collector &) = delete;
+
+            // User data for the workers of permutation_parallel::perm_all, one per worker;
+            // a sequential perm_all takes worker_data()[0].
+            std::vector<std::any> worker_data() const
+            {
+                std::vector<std::any> r;
+                for (const auto &l : locals_) r.emplace_back(l.get());
+                return r;
+            }
+
+            // The visitor to pass to perm_all with the user data of worker_data().
+            static void output_each_perm(const perm_iterator_type first, const perm_iterator_type last, const std::any &user_data)
+            {
+                std::any_cast<local *>(user_data)->offer(first, last);
+            }
+
+            // No permutation scoring above this can be among the best k.
+            // Score functions may use it to give up early.
+            TScore threshold() const { return threshold_.load(std::memory_order_relaxed); }
+
+            // The best k permutations, best first; equal scores are ordered by permutation.
+            // Call once the enumeration has finished.
+            std::vector<entry_type> results() const
+            {
+                std::vector<entry_type> r;
+                for (const auto &l : locals_) r.insert(std::end(r), std::begin(l->heap), std::end(l->heap));
+                const auto keep = std::min(k_, std::size(r));
+                std::partial_sort(std::begin(r), std::begin(r) + keep, std::end(r), better);
+                r.resize(keep);
+                return r;
+            }
+
+        private:
+            static bool better(const entry_type &a, const entry_type &b)
+            {
+                if (a.score != b.score) return a.score < b.score;
+                return a.perm < b.perm;
+            }
+
+            // A worker's heap, worst entry at the front; on its own cache lines.
+            struct alignas(64) local
+            {
+                explicit local(collector *c) : owner(c) {}
+
+                void offer(const perm_iterator_type first, const perm_iterator_type last)
+                {
+                    const auto &c = *owner;
+                    if (c.k_ == 0) return;
+                    const auto score = c.score_(first, last);
+                    if (c.threshold() < score) return;
+                    if (std::size(heap) < c.k_)
+                    {
+                        heap.push_back({score, perm_type(first, last)});
+                        std::push_heap(std::begin(heap), std::end(heap), better);
+                    }
+                    else
+                    {
+                        const auto &worst = heap.front();
+                        if (worst.score < score) return;
+                        if (score == worst.score && !std::lexicographical_compare(first, last, std::cbegin(worst.perm), std::cend(worst.perm))) return;
+                        std::pop_heap(std::begin(heap), std::end(heap), better);
+                        heap.back().score = score;
+                        heap.back().perm.assign(first, last);
+                        std::push_heap(std::begin(heap), std::end(heap), better);
+                    }
+                    if (std::size(heap) == c.k_) owner->lower_threshold(heap.front().score);
+                }
+
+                collector *owner;
+                std::vector<entry_type> heap;
+            };
+
+            void lower_threshold(const TScore score)
+            {
+                for (auto cur = threshold_.load(std::memory_order_relaxed); score < cur && !threshold_.compare_exchange_weak(cur, score, std::memory_order_relaxed); ) {}
+            }
+
+            static constexpr TScore no_threshold = std::numeric_limits<TScore>::has_infinity ? std::numeric_limits<TScore>::infinity() : std::numeric_limits<TScore>::max();
+
+            std::size_t k_;
+            score_function_type score_;
+            std::vector<std::unique_ptr<local>> locals_;
+            alignas(64) std::atomic<TScore> threshold_{no_threshold};
+        };
+    }
+}
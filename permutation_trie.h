@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "permutation.h"
+#include "permutation_map.h"
+#include "permutation_rank.h"
+
+namespace permutation_algorithms
+{
+    // A set of permutations of n distinct elements stored as a trie of their prefixes, for
+    // sets without a closed-form rank such as the permutations an enumeration kept after
+    // filtering. It is built in one pass over the permutations in lexicographic order.
+    //
+    // The nodes of depth 1 ... n-1 are stored in preorder; the last element of a
+    // permutation is implied by the others. The first child of a node is the next node
+    // and its next sibling is one subtree further, so navigating needs subtree sizes:
+    // - a node of depth n-1 is a leaf, one node and one permutation;
+    // - a node of depth n-2 has leaves for children, up to the next one flagged as a
+    //   last child by a bit per node;
+    // - nodes above hold their sizes in nodes and in permutations, found from the node's
+    //   position by a popcount rank over another bit per node.
+    // Each node also holds its element as a byte, an index into the sorted elements.
+    namespace trie
+    {
+        using index_type = std::uint8_t;
+
+        class builder;
+
+        class trie
+        {
+        public:
+            std::size_t n() const { return index_.n(); }
+            // The number of permutations.
+            rank_type size() const { return keys_; }
+            std::size_t nodes() const { return std::size(labels_); }
+            // Bytes of the node arrays.
+            std::size_t bytes() const
+            {
+                return std::size(labels_) + 8 * (std::size(sized_) + std::size(last_child_))
+                    + 4 * (std::size(word_rank_) + std::size(subtree_nodes_) + std::size(subtree_keys_));
+            }
+            const perm_index::indexer &index() const { return index_; }
+
+            // The rank of a permutation of the indices in the set, or nullopt if it is not in it.
+            std::optional<rank_type> rank(const std::span<const index_type> key) const
+            {
+                if (!is_permutation(key)) return std::nullopt;
+                if (keys_ == 0) return std::nullopt;
+                rank_type r = 0;
+                std::size_t p = 0, end = nodes();
+                for (std::size_t d = 1; d < n(); ++d)
+                {
+                    while (p < end && labels_[p] != key[d - 1])
+                    {
+                        r += subtree_keys(p, d);
+                        p += subtree_nodes(p, d);
+                    }
+                    if (p >= end) return std::nullopt;
+                    end = p + subtree_nodes(p, d);
+                    ++p;
+                }
+                return r;
+            }
+
+            // The rank of the permutation [first:last) of the elements in the set, or nullopt.
+            std::optional<rank_type> rank(const perm_iterator_type first, const perm_iterator_type last) const
+            {
+                std::vector<index_type> key;
+                if (!to_indices(first, last, key)) return std::nullopt;
+                return rank(key);
+            }
+
+            bool contains(const std::span<const index_type> key) const { return rank(key).has_value(); }
+            bool contains(const perm_iterator_type first, const perm_iterator_type last) const { return rank(first, last).has_value(); }
+
+            // The permutation of rank r in the set. Throws std::out_of_range if r >= size().
+            perm_type select(rank_type r) const
+            {
+                if (r >= keys_) throw std::out_of_range("rank out of range");
+                std::vector<index_type> key(n());
+                std::size_t p = 0;
+                for (std::size_t d = 1; d < n(); ++d)
+                {
+                    while (r >= subtree_keys(p, d))
+                    {
+                        r -= subtree_keys(p, d);
+                        p += subtree_nodes(p, d);
+                    }
+                    key[d - 1] = labels_[p];
+                    ++p;
+                }
+                return to_elements(key);
+            }
+
+            // Call visit(first, last) for every permutation in the set starting with the
+            // elements [prefix_first:prefix_last), in lexicographic order.
+            template <typename TVisit>
+            void for_each_prefix(const perm_iterator_type prefix_first, const perm_iterator_type prefix_last, TVisit visit) const
+            {
+                std::vector<index_type> key;
+                if (!to_indices(prefix_first, prefix_last, key, true) || keys_ == 0) return;
+                const auto k = std::size(key);
+                if (k >= n())
+                {
+                    if (rank(key)) emit(key, visit);
+                    return;
+                }
+                key.resize(n());
+                // Find the node of the prefix, at depth k, and the range of its children.
+                std::size_t p = 0, end = nodes();
+                for (std::size_t d = 1; d <= k; ++d)
+                {
+                    while (p < end && labels_[p] != key[d - 1]) p += subtree_nodes(p, d);
+                    if (p >= end) return;
+                    end = p + subtree_nodes(p, d);
+                    ++p;
+                }
+                walk(p, end, k + 1, key, visit);
+            }
+
+            template <typename TVisit>
+            void for_each(TVisit visit) const
+            {
+                for_each_prefix(perm_iterator_type{}, perm_iterator_type{}, visit);
+            }
+
+        private:
+            friend class builder;
+
+            explicit trie(perm_index::indexer index) : index_(std::move(index)) {}
+
+            std::size_t sized_index(const std::size_t p) const
+            {
+                const auto word = p / 64;
+                return word_rank_[word] + std::popcount(sized_[word] & ((std::uint64_t{1} << (p % 64)) - 1));
+            }
+            // The children of the node p of depth n-2: its following nodes up to the first
+            // last child.
+            std::size_t leaf_children(const std::size_t p) const
+            {
+                auto q = p + 1;
+                auto bits = last_child_[q / 64] >> (q % 64);
+                while (bits == 0)
+                {
+                    q = (q / 64 + 1) * 64;
+                    bits = last_child_[q / 64];
+                }
+                return q + std::countr_zero(bits) - p;
+            }
+            std::size_t subtree_nodes(const std::size_t p, const std::size_t d) const
+            {
+                if (d + 1 >= n()) return 1;
+                if (d + 2 == n()) return 1 + leaf_children(p);
+                return subtree_nodes_[sized_index(p)];
+            }
+            rank_type subtree_keys(const std::size_t p, const std::size_t d) const
+            {
+                if (d + 1 >= n()) return 1;
+                if (d + 2 == n()) return leaf_children(p);
+                return subtree_keys_[sized_index(p)];
+            }
+
+            bool is_permutation(const std::span<const index_type> key) const
+            {
+                if (std::size(key) != n()) return false;
+                std::uint32_t used = 0;
+                for (const auto i : key)
+                {
+                    if (i >= n() || (used >> i & 1)) return false;
+                    used |= std::uint32_t{1} << i;
+                }
+                return true;
+            }
+
+            // Look the elements up; with prefix, any distinct elements, else a permutation.
+            bool to_indices(const perm_iterator_type first, const perm_iterator_type last, std::vector<index_type> &key, const bool prefix = false) const
+            {
+                const auto &elems = index_.elements();
+                std::uint32_t used = 0;
+                for (auto it = first; it != last; ++it)
+                {
+                    const auto e = std::lower_bound(std::cbegin(elems), std::cend(elems), *it);
+                    if (e == std::cend(elems) || *e != *it) return false;
+                    const auto i = static_cast<index_type>(e - std::cbegin(elems));
+                    if (used >> i & 1) return false;
+                    used |= std::uint32_t{1} << i;
+                    key.push_back(i);
+                }
+                return prefix ? std::size(key) <= n() : std::size(key) == n();
+            }
+
+            perm_type to_elements(std::vector<index_type> &key) const
+            {
+                complete(key);
+                perm_type r(n());
+                for (std::size_t i = 0; i < n(); ++i) r[i] = index_.elements()[key[i]];
+                return r;
+            }
+
+            // Set the last index, implied by the others.
+            void complete(std::vector<index_type> &key) const
+            {
+                if (n() == 0) return;
+                std::uint32_t used = 0;
+                for (std::size_t i = 0; i + 1 < n(); ++i) used |= std::uint32_t{1} << key[i];
+                key[n() - 1] = static_cast<index_type>(std::countr_one(used));
+            }
+
+            template <typename TVisit>
+            void emit(std::vector<index_type> &key, TVisit &visit) const
+            {
+                const auto p = to_elements(key);
+                visit(std::cbegin(p), std::cend(p));
+            }
+
+            // Visit the permutations under the siblings [p:end) of depth d.
+            template <typename TVisit>
+            void walk(const std::size_t p, const std::size_t end, const std::size_t d, std::vector<index_type> &key, TVisit &visit) const
+            {
+                if (d >= n())
+                {
+                    emit(key, visit);
+                    return;
+                }
+                for (auto q = p; q < end; q += subtree_nodes(q, d))
+                {
+                    key[d - 1] = labels_[q];
+                    walk(q + 1, q + subtree_nodes(q, d), d + 1, key, visit);
+                }
+            }
+
+            perm_index::indexer index_;
+            rank_type keys_ = 0;
+            std::vector<index_type> labels_;
+            std::vector<std::uint64_t> last_child_;     // A bit per node, set for the last of its siblings.
+            std::vector<std::uint64_t> sized_;          // A bit per node, set for nodes above depth n-2.
+            std::vector<std::uint32_t> word_rank_;      // Set bits before each word of sized_.
+            std::vector<std::uint32_t> subtree_nodes_;  // Per node of sized_.
+            std::vector<std::uint32_t> subtree_keys_;   // Per node of sized_.
+        };
+
+        // Builds a trie from permutations added in increasing lexicographic order. Only the
+        // path of the last permutation is kept open; each node is appended in preorder when
+        // a permutation first reaches it, and its sizes are known once one leaves it.
+        class builder
+        {
+        public:
+            // [first:last): The elements, distinct.
+            builder(const perm_iterator_type first, const perm_iterator_type last) : trie_(perm_index::indexer(first, last)) {}
+
+            std::size_t n() const { return trie_.n(); }
+
+            // Add a permutation of the indices into the sorted elements. Throws
+            // std::invalid_argument unless it is a permutation following the last added.
+            void add(const std::span<const index_type> key)
+            {
+                if (!trie_.is_permutation(key)) throw std::invalid_argument("not a permutation");
+                const auto stored = n() > 0 ? n() - 1 : 0;
+                std::size_t common = 0;
+                if (trie_.keys_ > 0)
+                {
+                    const auto mismatch = std::mismatch(std::cbegin(last_), std::cend(last_), std::cbegin(key));
+                    common = static_cast<std::size_t>(mismatch.first - std::cbegin(last_));
+                    if (common >= stored || *mismatch.second < *mismatch.first) throw std::invalid_argument("permutations are not in increasing order");
+                }
+                if (trie_.keys_ == std::numeric_limits<std::uint32_t>::max()) throw std::length_error("trie too large");
+                close(common);
+                path_.resize(stored);
+                // The node of the last path that diverges gets a next sibling.
+                if (trie_.keys_ > 0) trie_.last_child_[path_[common] / 64] &= ~(std::uint64_t{1} << (path_[common] % 64));
+                for (auto d = common + 1; d <= stored; ++d)
+                {
+                    const auto p = trie_.nodes();
+                    if (p >= std::numeric_limits<std::uint32_t>::max()) throw std::length_error("trie too large");
+                    if (p % 64 == 0)
+                    {
+                        trie_.last_child_.push_back(0);
+                        trie_.sized_.push_back(0);
+                        trie_.word_rank_.push_back(static_cast<std::uint32_t>(std::size(trie_.subtree_nodes_)));
+                    }
+                    trie_.labels_.push_back(key[d - 1]);
+                    trie_.last_child_.back() |= std::uint64_t{1} << (p % 64);
+                    path_[d - 1] = p;
+                    if (d + 1 < stored)
+                    {
+                        trie_.sized_.back() |= std::uint64_t{1} << (p % 64);
+                        open_.push_back({p, std::size(trie_.subtree_nodes_), trie_.keys_});
+                        trie_.subtree_nodes_.push_back(0);
+                        trie_.subtree_keys_.push_back(0);
+                    }
+                }
+                last_.assign(std::cbegin(key), std::cend(key));
+                ++trie_.keys_;
+            }
+
+            // Add a permutation of the elements.
+            void add(const perm_iterator_type first, const perm_iterator_type last)
+            {
+                std::vector<index_type> key;
+                if (!trie_.to_indices(first, last, key)) throw std::invalid_argument("not a permutation");
+                add(key);
+            }
+
+            trie finish() &&
+            {
+                close(0);
+                return std::move(trie_);
+            }
+
+        private:
+            struct open_node
+            {
+                std::size_t position;
+                std::size_t sized;
+                rank_type keys_before;
+            };
+
+            // Fix the sizes of the open nodes of sized_ deeper than depth.
+            void close(const std::size_t depth)
+            {
+                while (std::size(open_) > depth)
+                {
+                    const auto &o = open_.back();
+                    trie_.subtree_nodes_[o.sized] = static_cast<std::uint32_t>(trie_.nodes() - o.position);
+                    trie_.subtree_keys_[o.sized] = static_cast<std::uint32_t>(trie_.keys_ - o.keys_before);
+                    open_.pop_back();
+                }
+            }
+
+            trie trie_;
+            std::vector<index_type> last_;
+            std::vector<std::size_t> path_;     // The nodes of the last permutation, by depth.
+            std::vector<open_node> open_;       // Its nodes of sized_, by depth.
+        };
+    }
+}
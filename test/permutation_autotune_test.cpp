@@ -0,0 +1,89 @@
+#include <sstream>
+#include <gtest/gtest.h>
+#include "../permutation_autotune.h"
+
+using namespace permutation_algorithms;
+
+TEST(permutation_autotune_test, profile_round_trip)
+{
+    autotune::profile prof;
+    prof.batch_size = 16384;
+    prof.entries = {{"count", 8, "4", 1, 2.5}, {"count", 8, "std", 4, 1.5}, {"print", 8, "2", 1, 30}};
+    std::stringstream ss;
+    autotune::write_profile(ss, prof);
+    const auto read = autotune::read_profile(ss);
+    EXPECT_EQ(read.batch_size, 16384u);
+    ASSERT_EQ(std::size(read.entries), 3u);
+    EXPECT_EQ(read.entries[1].engine, "std");
+    EXPECT_EQ(read.entries[1].threads, 4u);
+    EXPECT_DOUBLE_EQ(read.entries[1].ns_per_perm, 1.5);
+
+    std::istringstream bad("entry count eight 4 1 2.5\n");
+    EXPECT_THROW(autotune::read_profile(bad), std::runtime_error);
+}
+
+TEST(permutation_autotune_test, choose)
+{
+    autotune::profile prof;
+    prof.entries = {
+        {"count", 6, "2", 1, 3}, {"count", 6, "std", 4, 2},
+        {"count", 9, "4", 1, 2}, {"count", 9, "std", 4, 1},
+        {"print", 9, "4", 1, 40}, {"print", 9, "std", 4, 20},
+    };
+    registry::requirements req;
+    req.n = 10;
+    auto c = autotune::choose(prof, autotune::mode_count, req);
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->engine->name, "std");
+    EXPECT_EQ(c->threads, 4u);
+
+    // Nearest measured n below the request.
+    req.n = 7;
+    req.order = registry::perm_order::plain_changes;
+    c = autotune::choose(prof, autotune::mode_count, req);
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->engine->name, "2");
+
+    // Ordered printing does not use threads.
+    req.n = 9;
+    req.order = registry::perm_order::lexicographic;
+    EXPECT_FALSE(autotune::choose(prof, autotune::mode_print, req));
+    req.order = registry::perm_order::heap;
+    c = autotune::choose(prof, autotune::mode_print, req);
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->engine->name, "4");
+    EXPECT_EQ(c->threads, 1u);
+
+    // A given number of threads picks among the entries measured with it.
+    req.order.reset();
+    c = autotune::choose(prof, autotune::mode_count, req, 1);
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->engine->name, "4");
+    EXPECT_EQ(c->threads, 1u);
+    EXPECT_FALSE(autotune::choose(prof, autotune::mode_count, req, 2));
+
+    // Lexicographic ranks skip repeated elements, so they are not split across threads.
+    req.repeated = true;
+    c = autotune::choose(prof, autotune::mode_count, req);
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->engine->name, "4");
+    EXPECT_EQ(c->threads, 1u);
+}
+
+TEST(permutation_autotune_test, run)
+{
+    autotune::options opts;
+    opts.min_n = 3;
+    opts.max_n = 4;
+    opts.max_threads = 2;
+    opts.min_time = std::chrono::milliseconds(1);
+    const auto prof = autotune::run(opts, nullptr);
+    registry::requirements req;
+    req.n = 4;
+    for (const auto mode : {autotune::mode_count, autotune::mode_print})
+    {
+        const auto c = autotune::choose(prof, mode, req);
+        ASSERT_TRUE(c);
+        EXPECT_TRUE(registry::satisfies(*c->engine, req));
+    }
+}
@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_bnb.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    // An open tour through points 0 ... 8 on a line, elements named by their coordinate.
+    const perm_type cities{"7"sv, "2"sv, "9"sv, "0"sv, "5"sv, "1"sv, "8"sv, "3"sv, "6"sv};
+
+    double coord(const elem_type e) { return std::stod(std::string(e)); }
+
+    // The distance travelled, plus a penalty for starting anywhere but at 4.5.
+    double tour_cost(const perm_iterator_type first, const perm_iterator_type last)
+    {
+        double r = std::abs(coord(*first) - 4.5);
+        for (auto it = std::next(first); it != last; ++it) r += std::abs(coord(*it) - coord(*std::prev(it)));
+        return r;
+    }
+
+    // The cost of the prefix: every extension only adds distance.
+    double prefix_bound(const perm_iterator_type prefix_first, const perm_iterator_type prefix_last, const perm_iterator_type, const perm_iterator_type)
+    {
+        return tour_cost(prefix_first, prefix_last);
+    }
+
+    double brute_force_min()
+    {
+        auto p = cities;
+        std::sort(std::begin(p), std::end(p));
+        double r = std::numeric_limits<double>::infinity();
+        do r = std::min(r, tour_cost(std::cbegin(p), std::cend(p))); while (std::next_permutation(std::begin(p), std::end(p)));
+        return r;
+    }
+}
+
+TEST(permutation_bnb_test, finds_optimum)
+{
+    const auto expected = brute_force_min();
+    for (const unsigned int threads : {1u, 4u})
+    {
+        SCOPED_TRACE(threads);
+        const auto r = bnb::solve(std::cbegin(cities), std::cend(cities), tour_cost, prefix_bound, threads);
+        EXPECT_DOUBLE_EQ(r.cost, expected);
+        ASSERT_EQ(std::size(r.best), std::size(cities));
+        EXPECT_DOUBLE_EQ(tour_cost(std::cbegin(r.best), std::cend(r.best)), expected);
+        EXPECT_TRUE(std::is_permutation(std::cbegin(r.best), std::cend(r.best), std::cbegin(cities)));
+        EXPECT_EQ(r.perms, 362880.0);
+        EXPECT_LT(r.leaves, 362880u / 10);
+        EXPECT_GT(r.pruned, 0u);
+    }
+}
+
+TEST(permutation_bnb_test, without_pruning_visits_every_permutation)
+{
+    const perm_type elems{"a"sv, "b"sv, "c"sv, "d"sv, "e"sv, "f"sv};
+    std::vector<perm_type> seen;
+    const auto r = bnb::solve(std::cbegin(elems), std::cend(elems),
+        [&](const auto f, const auto l) {
+            seen.emplace_back(f, l);
+            return 1.0;
+        },
+        [](auto, auto, auto, auto) { return -std::numeric_limits<double>::infinity(); });
+    EXPECT_EQ(r.leaves, 720u);
+    EXPECT_EQ(r.pruned, 0u);
+    // Prefixes of length 0 ... 5: 1 + 6 + 30 + 120 + 360 + 720.
+    EXPECT_EQ(r.nodes, 1237u);
+    EXPECT_TRUE(std::is_sorted(std::cbegin(seen), std::cend(seen)));
+    EXPECT_EQ(std::size(seen), 720u);
+
+    // Nothing beats the incumbent.
+    const auto none = bnb::solve(std::cbegin(elems), std::cend(elems), [](auto, auto) { return 1.0; },
+        [](auto, auto, auto, auto) { return 0.0; }, 2, 1.0);
+    EXPECT_TRUE(none.best.empty());
+    EXPECT_EQ(none.leaves, 720u);
+}
+
+TEST(permutation_bnb_test, propagates_exceptions)
+{
+    const perm_type elems{"a"sv, "b"sv, "c"sv, "d"sv, "e"sv};
+    EXPECT_THROW(bnb::solve(std::cbegin(elems), std::cend(elems), [](auto, auto) -> double { throw std::runtime_error("cost"); },
+        [](auto, auto, auto, auto) { return 0.0; }, 3), std::runtime_error);
+}
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <optional>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_checksum.h"
+#include "../permutation_parallel.h"
+#include "../permutation_registry.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+TEST(permutation_checksum_test, same_for_every_engine)
+{
+    const perm_type elems{"1"sv, "2"sv, "3"sv, "4"sv, "5"sv, "6"sv};
+    std::optional<checksum::digest> expected;
+    for (const auto &e : registry::engines())
+    {
+        checksum::digest d;
+        e.perm_all(std::cbegin(elems), std::cend(elems), [&](const auto f, const auto l, const std::any &) { d.add(f, l); }, {});
+        if (!expected) expected = d;
+        EXPECT_EQ(d, *expected) << e.name;
+    }
+}
+
+TEST(permutation_checksum_test, detects_differences)
+{
+    std::vector<perm_type> perms;
+    perm_type p{"a"sv, "b"sv, "c"sv, "d"sv};
+    do perms.push_back(p); while (std::next_permutation(std::begin(p), std::end(p)));
+
+    checksum::digest all;
+    for (const auto &q : perms) all.add(std::cbegin(q), std::cend(q));
+    checksum::digest reversed;
+    for (auto it = std::crbegin(perms); it != std::crend(perms); ++it) reversed.add(std::cbegin(*it), std::cend(*it));
+    EXPECT_EQ(all, reversed);
+
+    // The first permutation twice and the last not at all.
+    checksum::digest duplicated;
+    for (std::size_t i = 0; i + 1 < std::size(perms); ++i) duplicated.add(std::cbegin(perms[i]), std::cend(perms[i]));
+    duplicated.add(std::cbegin(perms[0]), std::cend(perms[0]));
+    EXPECT_NE(all, duplicated);
+
+    // The same elements split differently.
+    const perm_type ab_c{"ab"sv, "c"sv}, a_bc{"a"sv, "bc"sv};
+    EXPECT_NE(checksum::perm_hash(std::cbegin(ab_c), std::cend(ab_c)), checksum::perm_hash(std::cbegin(a_bc), std::cend(a_bc)));
+}
+
+TEST(permutation_checksum_test, reduces_across_threads)
+{
+    const perm_type elems{"1"sv, "2"sv, "3"sv, "4"sv, "5"sv, "6"sv, "7"sv};
+    checksum::digest sequential;
+    permutation4::perm_all<perm_iterator_type>(std::cbegin(elems), std::cend(elems),
+        [&](const auto f, const auto l, const std::any &) { sequential.add(f, l); }, {});
+
+    std::vector<checksum::digest> parts(4);
+    std::vector<std::any> worker_data;
+    for (auto &d : parts) worker_data.emplace_back(&d);
+    permutation_parallel::perm_all(permutation_std::perm_range<perm_iterator_type>, std::cbegin(elems), std::cend(elems),
+        [](const auto f, const auto l, const std::any &user_data) { std::any_cast<checksum::digest *>(user_data)->add(f, l); }, worker_data);
+    checksum::digest parallel;
+    for (const auto &d : parts) parallel += d;
+    EXPECT_EQ(parallel, sequential);
+}
+
+TEST(permutation_checksum_test, to_string)
+{
+    const checksum::digest d{0x0123456789abcdefull, 0xfedcba9876543210ull};
+    EXPECT_EQ(checksum::to_string(d), "0123456789abcdeffedcba9876543210");
+    EXPECT_EQ(checksum::parse_digest(checksum::to_string(d)), d);
+    EXPECT_THROW(checksum::parse_digest("0123"), std::invalid_argument);
+    EXPECT_THROW(checksum::parse_digest("0123456789abcdeffedcba987654321g"), std::invalid_argument);
+}
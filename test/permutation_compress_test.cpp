@@ -0,0 +1,127 @@
+#include <string>
+#include <string_view>
+#include <zlib.h>
+#ifdef PERMUTATION_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef PERMUTATION_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+#include <gtest/gtest.h>
+#include "../permutation_compress.h"
+
+using namespace permutation_algorithms;
+
+namespace
+{
+    // Decompress a concatenation of gzip members.
+    std::string gunzip(const std::string_view data)
+    {
+        std::string r;
+        z_stream zs{};
+        EXPECT_EQ(inflateInit2(&zs, 15 + 16), Z_OK);
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(std::data(data)));
+        zs.avail_in = static_cast<uInt>(std::size(data));
+        char buf[4096];
+        while (zs.avail_in > 0)
+        {
+            zs.next_out = reinterpret_cast<Bytef *>(buf);
+            zs.avail_out = sizeof(buf);
+            const auto ret = inflate(&zs, Z_NO_FLUSH);
+            r.append(buf, sizeof(buf) - zs.avail_out);
+            if (ret == Z_STREAM_END) inflateReset(&zs);
+            else if (ret != Z_OK) break;
+        }
+        inflateEnd(&zs);
+        return r;
+    }
+
+#if defined(PERMUTATION_HAVE_ZSTD) || defined(PERMUTATION_HAVE_LZ4)
+    // Permutation lines, compressible but not trivially.
+    std::string sample_text()
+    {
+        std::string r;
+        for (int i = 0; i < 5000; ++i) r += std::to_string(i * 7919 % 5000) + " x \n";
+        return r;
+    }
+#endif
+}
+
+TEST(permutation_compress_test, parse_codec)
+{
+    EXPECT_EQ(compress::parse_codec("gzip"), compress::codec::gzip);
+    EXPECT_THROW(compress::parse_codec("bzip2"), std::domain_error);
+}
+
+TEST(permutation_compress_test, parallel_frames_in_order)
+{
+    std::string compressed;
+    std::string expected;
+    std::vector<compress::frame_offset> frames;
+    {
+        compress::parallel_compressor pc([&](const std::string_view frame) { compressed.append(frame); }, compress::codec::gzip, 1, 4);
+        output_buffer out(pc.sink(), 1000);
+        for (int i = 0; i < 5000; ++i)
+        {
+            const auto line = std::to_string(i);
+            const std::string_view elems[] = {line, "x"};
+            out.append(std::begin(elems), std::end(elems));
+            expected += line + " x \n";
+        }
+        out.flush();
+        pc.finish();
+        frames = pc.frames();
+    }
+    EXPECT_EQ(gunzip(compressed), expected);
+    EXPECT_LT(std::size(compressed), std::size(expected));
+
+    // Every frame decompresses on its own.
+    ASSERT_GT(std::size(frames), 10u);
+    EXPECT_EQ(frames[0].raw, 0u);
+    const auto &f = frames[std::size(frames) / 2], &g = frames[std::size(frames) / 2 + 1];
+    EXPECT_EQ(gunzip(std::string_view(compressed).substr(f.compressed, g.compressed - f.compressed)), expected.substr(f.raw, g.raw - f.raw));
+}
+
+#ifdef PERMUTATION_HAVE_ZSTD
+TEST(permutation_compress_test, zstd_frames)
+{
+    ASSERT_TRUE(compress::available(compress::codec::zstd));
+    const auto text = sample_text();
+    std::string compressed;
+    compress::compress_frame(compress::codec::zstd, 0, text, compressed);
+    const auto first = std::size(compressed);
+    compress::compress_frame(compress::codec::zstd, 19, text.substr(100), compressed);
+    EXPECT_LT(first, std::size(text));
+
+    // Each frame decompresses on its own.
+    std::string r(std::size(text), '\0');
+    auto n = ZSTD_decompress(std::data(r), std::size(r), std::data(compressed), first);
+    ASSERT_FALSE(ZSTD_isError(n)) << ZSTD_getErrorName(n);
+    EXPECT_EQ(r.substr(0, n), text);
+    n = ZSTD_decompress(std::data(r), std::size(r), std::data(compressed) + first, std::size(compressed) - first);
+    ASSERT_FALSE(ZSTD_isError(n)) << ZSTD_getErrorName(n);
+    EXPECT_EQ(r.substr(0, n), text.substr(100));
+}
+#endif
+
+#ifdef PERMUTATION_HAVE_LZ4
+TEST(permutation_compress_test, lz4_frames)
+{
+    ASSERT_TRUE(compress::available(compress::codec::lz4));
+    const auto text = sample_text();
+    std::string compressed;
+    compress::compress_frame(compress::codec::lz4, 0, text, compressed);
+    EXPECT_LT(std::size(compressed), std::size(text));
+
+    LZ4F_dctx *dctx = nullptr;
+    ASSERT_FALSE(LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)));
+    std::string r(std::size(text), '\0');
+    auto dst_size = std::size(r);
+    auto src_size = std::size(compressed);
+    const auto hint = LZ4F_decompress(dctx, std::data(r), &dst_size, std::data(compressed), &src_size, nullptr);
+    LZ4F_freeDecompressionContext(dctx);
+    EXPECT_EQ(hint, 0u);    // The frame is complete.
+    EXPECT_EQ(src_size, std::size(compressed));
+    EXPECT_EQ(r.substr(0, dst_size), text);
+}
+#endif
@@ -0,0 +1,58 @@
+#include <any>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_heap_table.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"0"sv, "1"sv, "2"sv, "3"sv, "4"sv, "5"sv, "6"sv, "7"sv, "8"sv};
+
+    std::vector<perm_type> heap_order(const std::size_t n)
+    {
+        return perm_all_container<std::vector<perm_type>>(permutation4::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::next(std::cbegin(test_elems), n));
+    }
+}
+
+TEST(permutation_heap_table_test, schedule_size)
+{
+    for (unsigned int m = 0; m <= permutation5::max_table_levels; ++m)
+    {
+        EXPECT_EQ(std::size(permutation5::schedule(m)), permutation_rank::factorial(m) - 1) << m;
+    }
+    EXPECT_THROW(permutation5::schedule(permutation5::max_table_levels + 1), std::out_of_range);
+}
+
+TEST(permutation_heap_table_test, same_order_as_permutation4)
+{
+    for (std::size_t n = 0; n <= std::size(test_elems); ++n)
+    {
+        const auto expected = heap_order(n);
+        for (unsigned int levels = 0; levels <= permutation5::max_table_levels; ++levels)
+        {
+            SCOPED_TRACE(testing::Message() << "n " << n << " levels " << levels);
+            perm_type a(std::cbegin(test_elems), std::next(std::cbegin(test_elems), n));
+            std::vector<perm_type> actual;
+            permutation5::perm_each(std::begin(a), std::end(a), [&](const auto f, const auto l) { actual.emplace_back(f, l); }, levels);
+            EXPECT_EQ(expected, actual);
+        }
+    }
+}
+
+TEST(permutation_heap_table_test, perm_range)
+{
+    // Ranges within one table pass and across the swaps of the levels above.
+    const auto expected = heap_order(std::size(test_elems));
+    for (const auto &[first, last] : std::vector<std::pair<rank_type, rank_type>>{{0, 362880}, {37, 701}, {5000, 5100}, {5039, 5041}, {100000, 100001}, {362879, 362880}})
+    {
+        SCOPED_TRACE(testing::Message() << first << "-" << last);
+        std::vector<perm_type> actual;
+        auto collect = [&](const auto f, const auto l, const std::any &) { actual.emplace_back(f, l); };
+        permutation5::perm_range(std::cbegin(test_elems), std::cend(test_elems), first, last, collect, {});
+        EXPECT_EQ(actual, std::vector<perm_type>(std::next(std::cbegin(expected), first), std::next(std::cbegin(expected), last)));
+    }
+    EXPECT_THROW(permutation5::perm_range(std::cbegin(test_elems), std::cend(test_elems), 0, 362881, [](auto, auto, const std::any &) {}, {}), std::out_of_range);
+}
@@ -0,0 +1,74 @@
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_indirect.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"0"sv, "1"sv, "2"sv, "3"sv, "4"sv, "5"sv};
+
+    // The permutations of test_elems by an indirect engine, as elements.
+    template <typename TEngine>
+    std::vector<perm_type> by_handles(TEngine engine)
+    {
+        std::vector<perm_type> r;
+        engine(std::size(test_elems), [&](const indirect::handles_type &h) {
+            perm_type p;
+            for (const auto i : h) p.push_back(test_elems[i]);
+            r.push_back(std::move(p));
+        });
+        return r;
+    }
+
+    template <typename TPermAll>
+    std::vector<perm_type> by_engine(TPermAll perm_all)
+    {
+        return perm_all_container<std::vector<perm_type>>(perm_all, std::cbegin(test_elems), std::cend(test_elems));
+    }
+}
+
+TEST(permutation_indirect_test, same_order_as_engines)
+{
+    EXPECT_EQ(by_handles([](auto n, auto v) { indirect::heap(n, v); }), by_engine(permutation4::perm_all<perm_iterator_type>));
+    EXPECT_EQ(by_handles([](auto n, auto v) { indirect::lexicographic(n, v); }), by_engine(permutation_std::perm_all<perm_iterator_type>));
+    EXPECT_EQ(by_handles([](auto n, auto v) { indirect::plain_changes(n, v); }), by_engine(permutation2::perm_all<perm_iterator_type>));
+}
+
+TEST(permutation_indirect_test, heavy_objects)
+{
+    using heavy = std::array<char, 256>;
+    std::vector<heavy> objects(5);
+    for (std::size_t i = 0; i < std::size(objects); ++i) objects[i].fill(static_cast<char>('a' + i));
+
+    std::size_t count = 0;
+    std::vector<heavy> last;
+    indirect::perm_all<heavy>(objects, registry::perm_order::heap, [&](const indirect::perm_view<heavy> &v) {
+        ASSERT_EQ(std::size(v), 5u);
+        for (std::size_t i = 0; i < std::size(v); ++i) EXPECT_EQ(&v[i], &objects[v.handles()[i]]);
+        EXPECT_EQ(std::distance(std::begin(v), std::end(v)), 5);
+        if (++count == 120) v.materialize(last);
+    });
+    EXPECT_EQ(count, 120u);
+    ASSERT_EQ(std::size(last), 5u);
+    EXPECT_NE(last, objects);
+    EXPECT_TRUE(std::is_permutation(std::cbegin(last), std::cend(last), std::cbegin(objects)));
+    EXPECT_THROW(indirect::perm_all<heavy>(objects, registry::perm_order::insertion, [](const auto &) {}), std::domain_error);
+}
+
+TEST(permutation_indirect_test, apply_moves)
+{
+    std::vector<std::unique_ptr<int>> objects;
+    for (int i = 0; i < 7; ++i) objects.push_back(std::make_unique<int>(i));
+    const indirect::handles_type handles{3, 0, 6, 1, 5, 4, 2};
+    indirect::apply(objects, handles);
+    for (std::size_t i = 0; i < std::size(objects); ++i)
+    {
+        ASSERT_TRUE(objects[i]);
+        EXPECT_EQ(*objects[i], static_cast<int>(handles[i]));
+    }
+}
@@ -0,0 +1,37 @@
+#include <string>
+#include <string_view>
+#include <gtest/gtest.h>
+#include "../permutation_job.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+TEST(permutation_job_test, split_elements)
+{
+    perm_type elems{"stale"sv};
+    split_elements("  a\tbb  c \r", elems);
+    EXPECT_EQ(elems, (perm_type{"a"sv, "bb"sv, "c"sv}));
+    split_elements(" \t", elems);
+    EXPECT_TRUE(elems.empty());
+}
+
+TEST(permutation_job_test, runner_reuses_output)
+{
+    std::string text;
+    {
+        output_buffer out([&](const std::string_view block) { text.append(block); }, 8);
+        job_runner runner("std", std::nullopt, nullptr, &out);
+        EXPECT_EQ(runner.run({"b"sv, "a"sv}), 2);
+        EXPECT_EQ(runner.run({"x"sv}), 1);
+    }
+    EXPECT_EQ(text, "a b \nb a \nx \n");
+}
+
+TEST(permutation_job_test, runner_auto)
+{
+    job_runner runner("auto", registry::perm_order::plain_changes, nullptr, nullptr);
+    EXPECT_EQ(runner.engine_for(4).properties.order, registry::perm_order::plain_changes);
+    EXPECT_EQ(runner.run({"1"sv, "2"sv, "3"sv, "4"sv}), 24);
+    EXPECT_EQ(runner.run({"1"sv, "2"sv, "3"sv}), 6);
+    EXPECT_THROW(job_runner("nonexistent", std::nullopt, nullptr, nullptr), std::domain_error);
+}
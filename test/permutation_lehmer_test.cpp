@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_lehmer.h"
+#include "../permutation_rank.h"
+
+using namespace permutation_algorithms;
+
+TEST(permutation_lehmer_test, fenwick_tree)
+{
+    lehmer::fenwick_tree t(10, [](const std::size_t i) { return i % 3 == 0; });     // 0, 3, 6, 9
+    EXPECT_EQ(t.prefix_sum(4), 2);
+    EXPECT_EQ(t.find_kth(0), 0u);
+    EXPECT_EQ(t.find_kth(2), 6u);
+    t.add(6, -1);
+    EXPECT_EQ(t.find_kth(2), 9u);
+    EXPECT_EQ(t.prefix_sum(10), 3);
+}
+
+TEST(permutation_lehmer_test, advance_matches_next_permutation)
+{
+    const std::vector<std::string> sorted{"a", "b", "c", "d", "e", "f"};
+    const auto total = permutation_rank::factorial(6);
+    for (rank_type start = 0; start < total; start += 37)
+    {
+        for (const rank_type step : {1ull, 2ull, 5ull, 119ull, 720ull, 1000ull})
+        {
+            auto p = sorted;
+            permutation_rank::unrank_lex(std::begin(p), std::end(p), start);
+            auto expected = sorted;
+            permutation_rank::unrank_lex(std::begin(expected), std::end(expected), (start + step) % total);
+
+            auto q = p;
+            EXPECT_EQ(lehmer::advance(std::begin(q), std::end(q), step), start + step < total);
+            EXPECT_EQ(q, expected) << start << " + " << step;
+            EXPECT_EQ(lehmer::retreat(std::begin(q), std::end(q), step), start + step < total);
+            EXPECT_EQ(q, p) << start << " + " << step << " - " << step;
+
+            // The same step as a big integer, converted by divide and conquer.
+            auto b = p;
+            EXPECT_EQ(lehmer::advance(std::begin(b), std::end(b), lehmer::big_rank_type(step)), start + step < total);
+            EXPECT_EQ(b, expected) << start << " + big " << step;
+        }
+    }
+}
+
+TEST(permutation_lehmer_test, steps_of_fewer_than_two_elements)
+{
+    // As std::next_permutation, any nonzero step wraps around.
+    std::vector<int> one{7}, none;
+    EXPECT_TRUE(lehmer::advance(std::begin(one), std::end(one), 0u));
+    EXPECT_FALSE(lehmer::advance(std::begin(one), std::end(one), 1u));
+    EXPECT_FALSE(lehmer::retreat(std::begin(one), std::end(one), lehmer::big_rank_type(5)));
+    EXPECT_FALSE(lehmer::advance(std::begin(none), std::end(none), 2u));
+    EXPECT_EQ(one, std::vector<int>{7});
+}
+
+TEST(permutation_lehmer_test, big_steps)
+{
+    std::vector<int> p(300);
+    std::iota(std::begin(p), std::end(p), 0);
+    const auto identity = p;
+
+    // 2^100 + 12345 and a step beyond 128 bits.
+    const lehmer::rank128_type step128 = (static_cast<lehmer::rank128_type>(1) << 100) + 12345;
+    const lehmer::big_rank_type big = lehmer::big_rank_type(1) << 400;
+
+    EXPECT_TRUE(lehmer::advance(std::begin(p), std::end(p), step128));
+    EXPECT_NE(p, identity);
+    // Only the last 35 elements can move: 2^101 < 35!.
+    EXPECT_TRUE(std::equal(std::cbegin(p), std::cend(p) - 35, std::cbegin(identity)));
+    EXPECT_TRUE(lehmer::advance(std::begin(p), std::end(p), big));
+    EXPECT_TRUE(lehmer::retreat(std::begin(p), std::end(p), big + lehmer::big_rank_type(step128)));
+    EXPECT_EQ(p, identity);
+
+    // Before the first permutation.
+    EXPECT_FALSE(lehmer::retreat(std::begin(p), std::end(p), 1u));
+    EXPECT_TRUE(std::is_sorted(std::crbegin(p), std::crend(p)));
+    EXPECT_FALSE(lehmer::advance(std::begin(p), std::end(p), 1u));
+    EXPECT_EQ(p, identity);
+}
+
+TEST(permutation_lehmer_test, rank_matches_64_bit_rank)
+{
+    std::vector<int> p(20);
+    std::iota(std::begin(p), std::end(p), 0);
+    const auto sorted = p;
+    for (const rank_type r : {0ull, 1ull, 123456789ull, 2432902008176640000ull - 1})
+    {
+        permutation_rank::unrank_lex(std::begin(p), std::end(p), r);
+        EXPECT_EQ(lehmer::rank_lex(std::cbegin(p), std::cend(p)), r);
+        std::vector<int> q(std::crbegin(sorted), std::crend(sorted));
+        lehmer::unrank_lex(std::begin(q), std::end(q), r);
+        EXPECT_EQ(q, p);
+        p = sorted;
+    }
+    EXPECT_EQ(lehmer::factorial(20), permutation_rank::factorial(20));
+}
+
+TEST(permutation_lehmer_test, big_rank_round_trip)
+{
+    for (const std::size_t n : {35u, 100u, 257u})
+    {
+        SCOPED_TRACE(n);
+        const auto total = lehmer::factorial(n);
+        // Ranks near both ends and in between.
+        const std::vector<lehmer::big_rank_type> ranks{0, 1, total / 3, total / 7 * 5 + 11, total - 1};
+        for (const auto &r : ranks)
+        {
+            const auto code = lehmer::rank_to_code(r, n);
+            for (std::size_t i = 0; i < n; ++i) ASSERT_LT(code[i], n - i);
+            EXPECT_EQ(lehmer::code_to_rank(code), r);
+
+            // Against the definition: sum of code[i] * (n - 1 - i)!.
+            lehmer::big_rank_type expected = 0;
+            for (std::size_t i = 0; i < n; ++i) expected = expected * (n - i) + code[i];
+            EXPECT_EQ(expected, r);
+
+            std::vector<int> p(n);
+            std::iota(std::begin(p), std::end(p), 0);
+            lehmer::unrank_lex(std::begin(p), std::end(p), r);
+            EXPECT_EQ(lehmer::lehmer_code(std::cbegin(p), std::cend(p)), code);
+            EXPECT_EQ(lehmer::rank_lex(std::cbegin(p), std::cend(p)), r);
+        }
+        EXPECT_THROW(lehmer::rank_to_code(total, n), std::out_of_range);
+    }
+}
@@ -0,0 +1,80 @@
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_map.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"d"sv, "b"sv, "e"sv, "a"sv, "c"sv, "f"sv};
+}
+
+TEST(permutation_map_test, rank_matches_rank_lex)
+{
+    const perm_index::indexer index(std::cbegin(test_elems), std::cend(test_elems));
+    EXPECT_EQ(index.size(), 720u);
+    rank_type expected = 0;
+    permutation_std::perm_all(std::cbegin(test_elems), std::cend(test_elems), [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) {
+        ASSERT_EQ(index.rank(f, l), expected);
+        ASSERT_EQ(index.rank(f, l), permutation_rank::rank_lex(f, l));
+        ASSERT_EQ(index.unrank(expected), perm_type(f, l));
+        ++expected;
+    }, {});
+
+    const std::vector<std::uint8_t> indices{5, 4, 3, 2, 1, 0};
+    EXPECT_EQ(index.rank(indices), 719u);
+    EXPECT_THROW(index.rank(std::vector<std::uint8_t>{0, 1, 2, 3, 4, 4}), std::invalid_argument);
+    EXPECT_THROW(index.rank(std::vector<std::uint8_t>{0, 1, 2, 3, 4, 40}), std::invalid_argument);
+    EXPECT_THROW(index.rank(std::vector<std::uint8_t>{0, 1, 2}), std::invalid_argument);
+    const perm_type stranger{"a"sv, "b"sv, "c"sv, "d"sv, "e"sv, "z"sv};
+    EXPECT_THROW(index.rank(std::cbegin(stranger), std::cend(stranger)), std::invalid_argument);
+    const perm_type repeated{"a"sv, "a"sv};
+    EXPECT_THROW(perm_index::indexer(std::cbegin(repeated), std::cend(repeated)), std::invalid_argument);
+}
+
+TEST(permutation_map_test, dense)
+{
+    perm_index::perm_map<bool> visited(std::cbegin(test_elems), std::cend(test_elems));
+    ASSERT_EQ(visited.size(), 720u);
+    int first_visits = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        permutation4::perm_all(std::cbegin(test_elems), std::cend(test_elems), [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) {
+            auto &v = visited.at(f, l);
+            if (!v) ++first_visits;
+            v = true;
+        }, {});
+    }
+    EXPECT_EQ(first_visits, 720);
+
+    perm_index::perm_map<int> scores(std::cbegin(test_elems), std::cend(test_elems), -1);
+    EXPECT_EQ(scores[719], -1);
+    const perm_type p{"f"sv, "e"sv, "d"sv, "c"sv, "b"sv, "a"sv};
+    scores.at(std::cbegin(p), std::cend(p)) = 7;
+    EXPECT_EQ(scores[719], 7);
+
+    const perm_type big(13, "x"sv);
+    EXPECT_THROW(perm_index::perm_map<int>(std::cbegin(big), std::cend(big)), std::length_error);
+}
+
+TEST(permutation_map_test, sparse)
+{
+    perm_type elems;
+    const std::vector<std::string> storage{"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15"};
+    for (const auto &s : storage) elems.emplace_back(s);
+    perm_index::sparse_perm_map<double, 1024> m(std::cbegin(elems), std::cend(elems));
+    EXPECT_EQ(m.index().size(), permutation_rank::factorial(16));
+
+    auto p = m.index().unrank(123456789012);
+    EXPECT_EQ(m.get(std::cbegin(p), std::cend(p)), 0.0);
+    EXPECT_EQ(m.pages(), 0u);
+    m.at(std::cbegin(p), std::cend(p)) = 2.5;
+    EXPECT_EQ(m.get(123456789012), 2.5);
+    EXPECT_EQ(m.get(123456789013), 0.0);
+    m[123456789013] += 1;
+    EXPECT_EQ(m.pages(), 1u);
+    EXPECT_THROW(m[permutation_rank::factorial(16)], std::out_of_range);
+}
@@ -0,0 +1,78 @@
+#include <any>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_matrix.h"
+
+using namespace permutation_algorithms;
+
+namespace
+{
+    // Distinct entries, so that any misplaced element shows.
+    std::vector<int> test_matrix(const std::size_t n)
+    {
+        std::vector<int> m(n * n);
+        std::iota(std::begin(m), std::end(m), 0);
+        return m;
+    }
+}
+
+TEST(permutation_matrix_test, views_match_gather)
+{
+    constexpr std::size_t n = 6;
+    const auto m = test_matrix(n);
+
+    // The positions in plain changes order, as permutation2 generates them.
+    std::vector<std::string> names(n);
+    perm_type indices;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        names[i] = std::to_string(i);
+        indices.emplace_back(names[i]);
+    }
+    std::vector<std::vector<matrix::index_type>> expected;
+    permutation2::perm_all(std::cbegin(indices), std::cend(indices), [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) {
+        auto &p = expected.emplace_back();
+        for (auto it = f; it != l; ++it) p.push_back(static_cast<matrix::index_type>(std::stoul(std::string(*it))));
+    }, {});
+
+    std::size_t count = 0;
+    std::vector<int> gathered(n * n);
+    matrix::for_each_permuted<int>(m, n, [&](const matrix::permuted_matrix<int> &view) {
+        ASSERT_LT(count, std::size(expected));
+        const auto &p = expected[count++];
+        ASSERT_TRUE(std::equal(std::cbegin(p), std::cend(p), std::cbegin(view.perm()), std::cend(view.perm())));
+        matrix::gather<int>(m, n, p, gathered);
+        ASSERT_TRUE(std::equal(std::cbegin(gathered), std::cend(gathered), std::cbegin(view.data()), std::cend(view.data())));
+    });
+    EXPECT_EQ(count, 720u);
+}
+
+TEST(permutation_matrix_test, swap)
+{
+    constexpr std::size_t n = 5;
+    const auto m = test_matrix(n);
+    matrix::permuted_matrix<int> view(m, n);
+    view.swap(0, 3);
+    view.swap(1, 4);
+    view.swap(2, 2);
+    view.swap_adjacent(2);
+
+    const std::vector<matrix::index_type> p{3, 4, 0, 2, 1};
+    EXPECT_TRUE(std::equal(std::cbegin(p), std::cend(p), std::cbegin(view.perm()), std::cend(view.perm())));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j) EXPECT_EQ(view(i, j), m[p[i] * n + p[j]]);
+        EXPECT_EQ(view.row(i)[1], view(i, 1));
+    }
+
+    EXPECT_THROW(matrix::permuted_matrix<int>(m, 4), std::invalid_argument);
+    std::size_t count = 0;
+    matrix::for_each_permuted<int>({}, 0, [&](const matrix::permuted_matrix<int> &) { ++count; });
+    EXPECT_EQ(count, 0u);
+    matrix::for_each_permuted<int>(std::vector<int>{7}, 1, [&](const matrix::permuted_matrix<int> &v) { EXPECT_EQ(v(0, 0), 7); ++count; });
+    EXPECT_EQ(count, 1u);
+}
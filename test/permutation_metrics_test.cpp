@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_metrics.h"
+
+using namespace permutation_algorithms;
+using metrics::index_perm_type;
+
+namespace
+{
+    index_perm_type random_perm(const std::size_t n, std::mt19937 &rng)
+    {
+        index_perm_type p(n);
+        std::iota(std::begin(p), std::end(p), 0);
+        std::shuffle(std::begin(p), std::end(p), rng);
+        return p;
+    }
+
+    // The definitions, in O(n^2).
+    std::uint64_t naive_kendall_tau(const index_perm_type &p, const index_perm_type &q)
+    {
+        const auto pp = metrics::inverse(p), pq = metrics::inverse(q);
+        std::uint64_t r = 0;
+        for (std::size_t a = 0; a < std::size(p); ++a)
+        {
+            for (auto b = a + 1; b < std::size(p); ++b)
+            {
+                if ((pp[a] < pp[b]) != (pq[a] < pq[b])) ++r;
+            }
+        }
+        return r;
+    }
+
+    std::uint64_t naive_ulam(const index_perm_type &p, const index_perm_type &q)
+    {
+        // Longest common subsequence by dynamic programming.
+        const auto n = std::size(p);
+        std::vector<std::vector<std::size_t>> lcs(n + 1, std::vector<std::size_t>(n + 1, 0));
+        for (std::size_t i = 1; i <= n; ++i)
+        {
+            for (std::size_t j = 1; j <= n; ++j)
+            {
+                lcs[i][j] = p[i - 1] == q[j - 1] ? lcs[i - 1][j - 1] + 1 : std::max(lcs[i - 1][j], lcs[i][j - 1]);
+            }
+        }
+        return n - lcs[n][n];
+    }
+
+    std::uint64_t naive_cayley(index_perm_type p, const index_perm_type &q)
+    {
+        // Selection sort of p into q, counting the swaps.
+        std::uint64_t swaps = 0;
+        for (std::size_t i = 0; i < std::size(p); ++i)
+        {
+            if (p[i] == q[i]) continue;
+            std::swap(p[i], *std::find(std::begin(p) + i, std::end(p), q[i]));
+            ++swaps;
+        }
+        return swaps;
+    }
+}
+
+TEST(permutation_metrics_test, match_definitions)
+{
+    std::mt19937 rng(42);
+    for (const std::size_t n : {0u, 1u, 2u, 7u, 50u, 301u})
+    {
+        for (int k = 0; k < 5; ++k)
+        {
+            const auto p = random_perm(n, rng), q = random_perm(n, rng);
+            EXPECT_EQ(metrics::kendall_tau(p, q), naive_kendall_tau(p, q));
+            EXPECT_EQ(metrics::ulam(p, q), naive_ulam(p, q));
+            EXPECT_EQ(metrics::cayley(p, q), naive_cayley(p, q));
+            const auto pp = metrics::inverse(p), pq = metrics::inverse(q);
+            std::uint64_t footrule = 0;
+            for (std::size_t i = 0; i < n; ++i) footrule += pp[i] > pq[i] ? pp[i] - pq[i] : pq[i] - pp[i];
+            EXPECT_EQ(metrics::footrule(p, q), footrule);
+            EXPECT_EQ(metrics::kendall_tau(p, p), 0u);
+        }
+    }
+    const index_perm_type id{0, 1, 2, 3}, rev{3, 2, 1, 0};
+    EXPECT_EQ(metrics::kendall_tau(id, rev), 6u);
+    EXPECT_EQ(metrics::footrule(id, rev), 8u);
+    EXPECT_EQ(metrics::cayley(id, rev), 2u);
+    EXPECT_EQ(metrics::ulam(id, rev), 3u);
+    EXPECT_THROW(metrics::kendall_tau(id, index_perm_type{0, 1}), std::invalid_argument);
+}
+
+TEST(permutation_metrics_test, kendall_tau_each)
+{
+    const index_perm_type reference{3, 0, 5, 1, 4, 2};
+    std::vector<index_perm_type> seen;
+    metrics::kendall_tau_each(reference, [&](const index_perm_type &p, const std::uint64_t distance) {
+        ASSERT_EQ(distance, metrics::kendall_tau(p, reference));
+        seen.push_back(p);
+    });
+    ASSERT_EQ(std::size(seen), 720u);
+    std::sort(std::begin(seen), std::end(seen));
+    EXPECT_EQ(std::adjacent_find(std::begin(seen), std::end(seen)), std::end(seen));
+}
+
+TEST(permutation_metrics_test, adjacent_swaps_follow_perm_all)
+{
+    using namespace std::literals::string_view_literals;
+    const perm_type elems{"a"sv, "b"sv, "c"sv, "d"sv, "e"sv};
+    const auto expected = perm_all_container<std::vector<perm_type>>(permutation2::perm_all<perm_iterator_type>, std::cbegin(elems), std::cend(elems));
+    std::vector<perm_type> actual{elems};
+    auto p = elems;
+    permutation2::perm_adjacent_swaps(5, [&](const int i) {
+        std::swap(p[i], p[i + 1]);
+        actual.push_back(p);
+    });
+    EXPECT_EQ(actual, expected);
+}
@@ -0,0 +1,45 @@
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_numa.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+TEST(permutation_numa_test, parse_cpulist)
+{
+    EXPECT_EQ(numa::parse_cpulist("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(numa::parse_cpulist("\n").empty());
+    EXPECT_FALSE(numa::topology().empty());
+}
+
+TEST(permutation_numa_test, covers_all_permutations_per_node)
+{
+    const perm_type elems{"1"sv, "2"sv, "3"sv, "4"sv, "5"sv, "6"sv};
+    // Two made-up nodes on CPUs that may not exist; pinning is best effort.
+    const std::vector<numa::node> nodes{{0, {0}}, {1, {1}}};
+    std::mutex m;
+    std::vector<perm_type> actual;
+    std::vector<unsigned int> init_nodes;
+    const auto report = numa::perm_all(permutation_std::perm_range<perm_iterator_type>, std::cbegin(elems), std::cend(elems),
+        [&](const auto f, const auto l, const std::any &) {
+            std::lock_guard lock(m);
+            actual.emplace_back(f, l);
+        },
+        [&](const numa::worker &w) -> std::any {
+            std::lock_guard lock(m);
+            init_nodes.push_back(w.node);
+            return {};
+        },
+        3, nodes);
+
+    std::sort(std::begin(actual), std::end(actual));
+    EXPECT_EQ(actual, perm_all_container<std::vector<perm_type>>(permutation_std::perm_all<perm_iterator_type>, std::cbegin(elems), std::cend(elems)));
+    std::sort(std::begin(init_nodes), std::end(init_nodes));
+    EXPECT_EQ(init_nodes, (std::vector<unsigned int>{0, 0, 1}));
+    ASSERT_EQ(std::size(report), 2u);
+    EXPECT_EQ(report[0].workers, 2u);
+    EXPECT_EQ(report[1].workers, 1u);
+    EXPECT_EQ(report[0].perms + report[1].perms, 720u);
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <string_view>
+#include <gtest/gtest.h>
+#include "../permutation_parallel.h"
+#include "../permutation_rank.h"
+#include "../permutation_registry.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"1"sv, "2"sv, "3"sv, "4"sv, "5"sv, "6"sv};
+}
+
+TEST(permutation_rank_test, rank_unrank_lex)
+{
+    using namespace permutation_rank;
+    EXPECT_EQ(factorial(0), 1u);
+    EXPECT_EQ(factorial(20), 2432902008176640000u);
+    EXPECT_THROW(factorial(21), std::overflow_error);
+
+    auto a = test_elems;
+    rank_type r = 0;
+    do {
+        auto b = test_elems;
+        unrank_lex(std::begin(b), std::end(b), r);
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(rank_lex(std::cbegin(a), std::cend(a)), r);
+        ++r;
+    } while (std::next_permutation(std::begin(a), std::end(a)));
+}
+
+TEST(permutation_rank_test, perm_range)
+{
+    using namespace permutation_std;
+    const auto expected = perm_all_container<std::vector<perm_type>>(perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    std::vector<perm_type> actual;
+    auto collect = [&](const auto f, const auto l, const std::any &) { actual.emplace_back(f, l); };
+    perm_range(std::cbegin(test_elems), std::cend(test_elems), 100, 250, collect, {});
+    EXPECT_EQ(actual, std::vector<perm_type>(std::next(std::cbegin(expected), 100), std::next(std::cbegin(expected), 250)));
+
+    // perm_all() gives 3 permutations of a a b, which 3! ranks cannot follow.
+    const perm_type repeated{"a"sv, "b"sv, "a"sv};
+    EXPECT_THROW(perm_range(std::cbegin(repeated), std::cend(repeated), 0, 6, collect, {}), std::invalid_argument);
+}
+
+TEST(permutation_parallel_test, rejects_repeated_elements)
+{
+    const perm_type repeated{"a"sv, "a"sv, "b"sv};
+    std::vector<std::any> worker_data(2);
+    EXPECT_THROW(permutation_parallel::perm_all(permutation_std::perm_range<perm_iterator_type>, std::cbegin(repeated), std::cend(repeated),
+        [](const auto, const auto, const std::any &) {}, worker_data), std::invalid_argument);
+}
+
+TEST(permutation_parallel_test, covers_all_permutations)
+{
+    const auto expected = perm_all_container<std::vector<perm_type>>(permutation_std::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    for (const unsigned int threads : {1u, 3u, 8u})
+    {
+        std::mutex m;
+        std::vector<perm_type> actual;
+        std::vector<std::any> worker_data(threads);
+        permutation_parallel::perm_all(permutation_std::perm_range<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems),
+            [&](const auto f, const auto l, const std::any &) {
+                std::lock_guard lock(m);
+                actual.emplace_back(f, l);
+            },
+            worker_data);
+        std::sort(std::begin(actual), std::end(actual));
+        EXPECT_EQ(expected, actual);
+    }
+}
+
+TEST(permutation_rank_test, heap_perm_range)
+{
+    const auto expected = perm_all_container<std::vector<perm_type>>(permutation4::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    for (rank_type r = 0; r < std::size(expected); ++r)
+    {
+        auto a = test_elems;
+        permutation_rank::unrank_heap(std::begin(a), std::end(a), r);
+        ASSERT_EQ(a, expected[r]) << "rank " << r;
+    }
+
+    std::vector<perm_type> actual;
+    auto collect = [&](const auto f, const auto l, const std::any &) { actual.emplace_back(f, l); };
+    permutation4::perm_range(std::cbegin(test_elems), std::cend(test_elems), 37, 701, collect, {});
+    EXPECT_EQ(actual, std::vector<perm_type>(std::next(std::cbegin(expected), 37), std::next(std::cbegin(expected), 701)));
+}
+
+TEST(permutation_parallel_test, ordered_output_matches_sequential)
+{
+    auto format = [](const perm_iterator_type f, const perm_iterator_type l, const std::any &user_data) {
+        format_perm(*std::any_cast<std::string *>(user_data), f, l);
+    };
+    // Lexicographic ranks need distinct elements; the other engines permute positions.
+    const std::tuple<perm_all_function_type, perm_range_function_type, bool> engines[] = {
+        {permutation_std::perm_all<perm_iterator_type>, permutation_std::perm_range<perm_iterator_type>, true},
+        {permutation1::perm_all<perm_iterator_type>, permutation1::perm_range<perm_iterator_type>, false},
+        {permutation4::perm_all<perm_iterator_type>, permutation4::perm_range<perm_iterator_type>, false},
+    };
+    const perm_type repeated{"1"sv, "2"sv, "1"sv, "3"sv, "2"sv, "4"sv};
+    for (const auto &[perm_all, perm_range, distinct_only] : engines)
+    {
+        for (const auto *elems : {&test_elems, &repeated})
+        {
+            // One thread of perm_all(), as printed without --threads.
+            std::string expected;
+            perm_all(std::cbegin(*elems), std::cend(*elems), format, &expected);
+            for (const unsigned int threads : {1u, 4u})
+            {
+                std::string actual;
+                size_t blocks = 0;
+                const auto run = [&] {
+                    permutation_parallel::perm_all_ordered(perm_range, std::cbegin(*elems), std::cend(*elems), format,
+                        [&](const std::string_view block) { actual.append(block); ++blocks; }, threads, 7, 3);
+                };
+                if (distinct_only && elems == &repeated)
+                {
+                    EXPECT_THROW(run(), std::invalid_argument);
+                    continue;
+                }
+                run();
+                EXPECT_EQ(expected, actual);
+                EXPECT_EQ(blocks, (720u + 6) / 7);
+            }
+        }
+    }
+}
+
+TEST(permutation_rank_test, plain_changes_perm_range)
+{
+    const auto expected = perm_all_container<std::vector<perm_type>>(permutation2::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    for (rank_type r = 0; r < std::size(expected); ++r)
+    {
+        auto a = test_elems;
+        permutation_rank::unrank_plain_changes(std::begin(a), std::end(a), r);
+        ASSERT_EQ(a, expected[r]) << "rank " << r;
+    }
+
+    std::vector<perm_type> actual;
+    auto collect = [&](const auto f, const auto l, const std::any &) { actual.emplace_back(f, l); };
+    permutation2::perm_range(std::cbegin(test_elems), std::cend(test_elems), 119, 720, collect, {});
+    EXPECT_EQ(actual, std::vector<perm_type>(std::next(std::cbegin(expected), 119), std::cend(expected)));
+    EXPECT_THROW(permutation2::perm_range(std::cbegin(test_elems), std::cend(test_elems), 0, 721, collect, {}), std::out_of_range);
+}
+
+TEST(permutation_rank_test, insertion_perm_range)
+{
+    // Insertion of c into every position of b a, then of a b.
+    const perm_type abc{"a"sv, "b"sv, "c"sv};
+    EXPECT_EQ(perm_all_container<std::vector<perm_type>>(permutation1::perm_all<perm_iterator_type>, std::cbegin(abc), std::cend(abc)),
+        (std::vector<perm_type>{{"c"sv, "b"sv, "a"sv}, {"b"sv, "c"sv, "a"sv}, {"b"sv, "a"sv, "c"sv},
+            {"c"sv, "a"sv, "b"sv}, {"a"sv, "c"sv, "b"sv}, {"a"sv, "b"sv, "c"sv}}));
+
+    const auto expected = perm_all_container<std::vector<perm_type>>(permutation1::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    ASSERT_EQ(std::size(expected), 720u);
+    permutation1::generator g(std::cbegin(test_elems), std::cend(test_elems));
+    for (rank_type r = 0; r < std::size(expected); ++r)
+    {
+        ASSERT_EQ(permutation_rank::insertion_rank(g.digits()), r);
+        ASSERT_EQ(g.digits(), permutation_rank::insertion_digits(6, r));
+        // Resuming from a checkpoint continues where the generator is.
+        const permutation1::generator resumed(std::cbegin(test_elems), std::cend(test_elems), g.digits());
+        ASSERT_TRUE(std::equal(std::cbegin(resumed), std::cend(resumed), std::cbegin(expected[r]), std::cend(expected[r]))) << "rank " << r;
+        ASSERT_EQ(g.next(), r + 1 < std::size(expected));
+    }
+    EXPECT_TRUE(std::equal(std::cbegin(g), std::cend(g), std::cbegin(expected.back()), std::cend(expected.back())));
+
+    std::vector<perm_type> actual;
+    auto collect = [&](const auto f, const auto l, const std::any &) { actual.emplace_back(f, l); };
+    permutation1::perm_range(std::cbegin(test_elems), std::cend(test_elems), 43, 600, collect, {});
+    EXPECT_EQ(actual, std::vector<perm_type>(std::next(std::cbegin(expected), 43), std::next(std::cbegin(expected), 600)));
+    EXPECT_THROW(permutation1::perm_range(std::cbegin(test_elems), std::cend(test_elems), 0, 721, collect, {}), std::out_of_range);
+    EXPECT_THROW(permutation1::generator(std::cbegin(test_elems), std::cend(test_elems), std::vector<int>{0, 2, 0, 0, 0, 0}), std::invalid_argument);
+    EXPECT_THROW(permutation1::generator(std::cbegin(test_elems), std::cend(test_elems), std::vector<int>{0, 0}), std::invalid_argument);
+}
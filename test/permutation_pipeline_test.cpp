@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_pipeline.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"1"sv, "2"sv, "3"sv, "4"sv, "5"sv, "6"sv};
+
+    template <typename TQueue>
+    void check_queue_transfers_all(const int producers, const int consumers)
+    {
+        constexpr int per_producer = 20000;
+        TQueue q(8);
+        std::vector<std::thread> threads;
+        std::vector<std::vector<int>> received(consumers);
+        std::atomic<int> remaining{producers * per_producer};
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < per_producer; ++i) pipeline::wait_until([&] { return q.try_push(p * per_producer + i); });
+            });
+        }
+        for (int c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&, c] {
+                for (int v; remaining > 0; )
+                {
+                    if (!q.try_pop(v))
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    received[c].push_back(v);
+                    --remaining;
+                }
+            });
+        }
+        for (auto &t : threads) t.join();
+
+        std::vector<int> all;
+        for (const auto &r : received)
+        {
+            // Each producer's values arrive in order.
+            if (producers == 1)
+            {
+                EXPECT_TRUE(std::is_sorted(std::cbegin(r), std::cend(r)));
+            }
+            all.insert(std::end(all), std::cbegin(r), std::cend(r));
+        }
+        std::sort(std::begin(all), std::end(all));
+        ASSERT_EQ(std::size(all), static_cast<size_t>(producers * per_producer));
+        for (int i = 0; i < producers * per_producer; ++i) ASSERT_EQ(all[i], i);
+    }
+}
+
+TEST(permutation_pipeline_test, spsc_ring)
+{
+    pipeline::spsc_ring<int> q(3);
+    int v;
+    EXPECT_FALSE(q.try_pop(v));
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(q.try_push(i));
+    EXPECT_FALSE(q.try_push(4));
+    EXPECT_TRUE(q.try_pop(v));
+    EXPECT_EQ(v, 0);
+    check_queue_transfers_all<pipeline::spsc_ring<int>>(1, 1);
+}
+
+TEST(permutation_pipeline_test, mpmc_ring)
+{
+    check_queue_transfers_all<pipeline::mpmc_ring<int>>(1, 3);
+    check_queue_transfers_all<pipeline::mpmc_ring<int>>(3, 1);
+    check_queue_transfers_all<pipeline::mpmc_ring<int>>(2, 2);
+}
+
+TEST(permutation_pipeline_test, run_keeps_order_with_reorder_sink)
+{
+    std::string expected;
+    permutation4::perm_all(std::cbegin(test_elems), std::cend(test_elems),
+        [&](const auto f, const auto l, const std::any &) { format_perm(expected, f, l); }, {});
+
+    for (const unsigned int consumers : {1u, 3u})
+    {
+        std::string actual;
+        pipeline::reorder_sink sink([&](const std::string_view block) { actual.append(block); });
+        pipeline::options opts;
+        opts.consumers = consumers;
+        opts.depth = 2;
+        opts.batch_perms = 50;
+        pipeline::run(permutation4::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems), opts,
+            [&](const pipeline::perm_batch &b, unsigned int) {
+                std::string text;
+                for (size_t i = 0; i < b.count; ++i) format_perm(text, b.perm_begin(i), b.perm_end(i));
+                sink.write(b.seq, std::move(text));
+            });
+        EXPECT_EQ(expected, actual);
+    }
+}
+
+TEST(permutation_pipeline_test, consumer_error_stops_generator)
+{
+    pipeline::options opts;
+    opts.consumers = 2;
+    opts.depth = 2;
+    opts.batch_perms = 10;
+    EXPECT_THROW(pipeline::run(permutation4::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems), opts,
+        [&](const pipeline::perm_batch &b, unsigned int) {
+            if (b.seq == 3) throw std::runtime_error("consumer failed");
+        }), std::runtime_error);
+}
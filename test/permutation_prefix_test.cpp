@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_prefix.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"d"sv, "a"sv, "f"sv, "c"sv, "b"sv, "e"sv, "g"sv};
+
+    // The concatenation of the elements, built one at a time.
+    std::string append(const std::string &state, const elem_type e, std::size_t)
+    {
+        return state + std::string(e);
+    }
+}
+
+TEST(permutation_prefix_test, next_permutation_pivot)
+{
+    std::vector<int> a{1, 2, 3, 4}, b = a;
+    for (;;)
+    {
+        const auto before = a;
+        const auto pivot = prefix_eval::next_permutation_pivot(std::begin(a), std::end(a));
+        const bool more = std::next_permutation(std::begin(b), std::end(b));
+        ASSERT_EQ(a, b);
+        if (!more)
+        {
+            EXPECT_EQ(pivot, 4u);
+            break;
+        }
+        EXPECT_TRUE(std::equal(std::cbegin(a), std::cbegin(a) + pivot, std::cbegin(before)));
+        EXPECT_NE(a[pivot], before[pivot]);
+    }
+}
+
+TEST(permutation_prefix_test, perm_all_lex)
+{
+    const auto expected = perm_all_container<std::vector<perm_type>>(permutation_std::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    std::size_t i = 0;
+    const auto steps = prefix_eval::perm_all_lex(std::cbegin(test_elems), std::cend(test_elems), std::string(), append,
+        [&](const auto first, const auto last, const std::string &state) {
+            ASSERT_LT(i, std::size(expected));
+            EXPECT_TRUE(std::equal(first, last, std::cbegin(expected[i]), std::cend(expected[i])));
+            std::string concat;
+            for (const auto e : expected[i]) concat += e;
+            EXPECT_EQ(state, concat);
+            ++i;
+        });
+    EXPECT_EQ(i, 5040u);
+    // Fewer than e steps per permutation, against 7 without memoization.
+    EXPECT_LT(steps, 5040u * 2.72);
+}
+
+TEST(permutation_prefix_test, perm_range_lex)
+{
+    std::vector<std::string> actual;
+    for (const auto &[lo, hi] : {std::pair<rank_type, rank_type>{0, 1000}, {1000, 1001}, {1001, 5040}})
+    {
+        prefix_eval::perm_range_lex(std::cbegin(test_elems), std::cend(test_elems), lo, hi, std::string(), append,
+            [&](auto, auto, const std::string &state) { actual.push_back(state); });
+    }
+    ASSERT_EQ(std::size(actual), 5040u);
+    EXPECT_TRUE(std::is_sorted(std::cbegin(actual), std::cend(actual)));
+    EXPECT_EQ(std::adjacent_find(std::cbegin(actual), std::cend(actual)), std::cend(actual));
+    EXPECT_THROW(prefix_eval::perm_range_lex(std::cbegin(test_elems), std::cend(test_elems), 0, 5041, std::string(), append, [](auto, auto, const auto &) {}),
+        std::out_of_range);
+}
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <vector>
+#include <string_view>
+#include <gtest/gtest.h>
+#include "../permutation_registry.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"1"sv, "2"sv, "3"sv, "4"sv, "5"sv};
+
+    std::vector<perm_type> collect(const registry::engine &e, const perm_type &elems)
+    {
+        return perm_all_container<std::vector<perm_type>>(e.perm_all, std::cbegin(elems), std::cend(elems));
+    }
+}
+
+TEST(permutation_registry_test, all_engines_generate_same_set)
+{
+    auto expected = collect(registry::get_engine("std"), test_elems);
+    ASSERT_EQ(std::size(expected), 120u);
+    for (const auto &e : registry::engines())
+    {
+        SCOPED_TRACE(e.name);
+        auto actual = collect(e, test_elems);
+        std::sort(std::begin(actual), std::end(actual));
+        EXPECT_EQ(expected, actual);
+    }
+}
+
+TEST(permutation_registry_test, properties_hold)
+{
+    for (const auto &e : registry::engines())
+    {
+        SCOPED_TRACE(e.name);
+        const auto r = collect(e, test_elems);
+        if (e.properties.order == registry::perm_order::lexicographic)
+        {
+            EXPECT_TRUE(std::is_sorted(std::cbegin(r), std::cend(r)));
+        }
+        for (size_t i = 1; e.properties.transposition && i < std::size(r); ++i)
+        {
+            std::vector<size_t> diff;
+            for (size_t j = 0; j < std::size(test_elems); ++j)
+            {
+                if (r[i - 1][j] != r[i][j]) diff.push_back(j);
+            }
+            ASSERT_EQ(std::size(diff), 2u);
+            if (e.properties.adjacent)
+            {
+                EXPECT_EQ(diff[0] + 1, diff[1]);
+            }
+        }
+    }
+}
+
+TEST(permutation_registry_test, select_engine)
+{
+    EXPECT_THROW(registry::get_engine("nonexistent"), std::domain_error);
+
+    registry::requirements req;
+    req.n = std::size(test_elems);
+    const auto &fastest = registry::select_engine(req);
+    for (const auto &e : registry::engines()) EXPECT_LE(fastest.cost, e.cost);
+
+    req.order = registry::perm_order::lexicographic;
+    EXPECT_EQ(registry::select_engine(req).name, "std");
+    req.repeated = true;
+    EXPECT_EQ(registry::select_engine(req).name, "std");
+    req.parallel = true;
+    EXPECT_THROW(registry::select_engine(req), std::domain_error);
+    req.parallel = false;
+    req.repeated = false;
+    req.order = registry::perm_order::plain_changes;
+    EXPECT_TRUE(registry::select_engine(req).properties.adjacent);
+}
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include "../permutation_server.h"
+
+using namespace permutation_algorithms;
+
+namespace
+{
+    class permutation_server_test : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            path_ = std::filesystem::temp_directory_path() / ("permutation_server_test." + std::to_string(::getpid()));
+            srv_.emplace(path_, 2);
+            thread_ = std::thread([this] { srv_->run(); });
+        }
+        void TearDown() override
+        {
+            srv_->stop();
+            thread_.join();
+            srv_.reset();
+            EXPECT_FALSE(std::filesystem::exists(path_));
+        }
+
+        std::filesystem::path path_;
+        std::optional<server::server> srv_;
+        std::thread thread_;
+    };
+
+    std::vector<std::vector<std::uint8_t>> collect(server::client &c, const server::job_request &job)
+    {
+        std::vector<std::vector<std::uint8_t>> r;
+        const auto count = c.run(job, [&](const auto perm) { r.emplace_back(std::begin(perm), std::end(perm)); });
+        EXPECT_EQ(count, static_cast<int64_t>(std::size(r)));
+        return r;
+    }
+}
+
+TEST_F(permutation_server_test, jobs_on_one_connection)
+{
+    server::client c(path_);
+
+    server::job_request job;
+    job.elements = {"c", "a", "b"};
+    job.algorithm = "std";
+    // Lexicographic order of the element values; indices refer to the job's element order.
+    const std::vector<std::vector<std::uint8_t>> expected{{1, 2, 0}, {1, 0, 2}, {2, 1, 0}, {2, 0, 1}, {0, 1, 2}, {0, 2, 1}};
+    EXPECT_EQ(collect(c, job), expected);
+
+    job.range.emplace(2, 5);
+    EXPECT_EQ(collect(c, job), decltype(expected)(std::next(std::cbegin(expected), 2), std::next(std::cbegin(expected), 5)));
+
+    job.range.reset();
+    job.algorithm = "auto";
+    job.count_only = true;
+    job.elements = {"1", "2", "3", "4", "5", "6", "7", "8"};
+    EXPECT_EQ(c.run(job), 40320);
+
+    // Errors are reported and the connection stays usable.
+    job.algorithm = "nonexistent";
+    EXPECT_THROW(c.run(job), std::runtime_error);
+    job.algorithm = "3";
+    job.range.emplace(0, 1);
+    EXPECT_THROW(c.run(job), std::runtime_error);
+    job.range.reset();
+    job.count_only = false;
+    job.elements = {"", "x"};
+    EXPECT_EQ(collect(c, job).size(), 2u);
+}
+
+TEST_F(permutation_server_test, concurrent_clients)
+{
+    std::vector<std::thread> clients;
+    std::vector<int64_t> counts(4);
+    for (size_t i = 0; i < std::size(counts); ++i)
+    {
+        clients.emplace_back([&, i] {
+            server::client c(path_);
+            server::job_request job;
+            job.elements = {"a", "b", "c", "d", "e", "f", "g"};
+            job.algorithm = "2";
+            counts[i] = static_cast<int64_t>(std::size(collect(c, job)));
+        });
+    }
+    for (auto &t : clients) t.join();
+    for (const auto count : counts) EXPECT_EQ(count, 5040);
+}
+
+TEST_F(permutation_server_test, auto_jobs_follow_profile)
+{
+    // A profile in which plain changes is the fastest printing engine.
+    autotune::profile prof;
+    prof.entries = {{"print", 4, "2", 1, 1.0}, {"print", 4, "4", 1, 2.0}, {"count", 4, "4", 1, 1.0}};
+    const auto path = path_.string() + ".profile";
+    server::server srv(path, 1, prof);
+    std::thread t([&] { srv.run(); });
+
+    server::client c(path);
+    server::job_request job;
+    job.elements = {"0", "1", "2", "3"};
+    std::vector<std::vector<std::uint8_t>> expected;
+    permutation2::perm_all(std::cbegin(job.elements), std::cend(job.elements), [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) {
+        auto &p = expected.emplace_back();
+        for (auto it = f; it != l; ++it) p.push_back(static_cast<std::uint8_t>(it->front() - '0'));
+    }, {});
+    EXPECT_EQ(collect(c, job), expected);
+
+    srv.stop();
+    t.join();
+}
+
+TEST_F(permutation_server_test, stop_ends_count_only_job)
+{
+    // 14! permutations would take hours to count.
+    std::thread t([&] {
+        server::client c(path_);
+        server::job_request job;
+        job.elements = {"a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n"};
+        job.algorithm = "4";
+        job.count_only = true;
+        EXPECT_THROW(c.run(job), std::exception);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    srv_->stop();
+    t.join();
+}
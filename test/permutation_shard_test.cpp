@@ -0,0 +1,109 @@
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_shard.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    // Manifests of count shards of n elements, as --shard writes them.
+    std::vector<shard::manifest> make_shards(const std::size_t n, const rank_type count)
+    {
+        std::vector<shard::manifest> r;
+        for (rank_type i = 0; i < count; ++i)
+        {
+            shard::manifest m;
+            m.algorithm = "2";
+            m.order = "plain_changes";
+            m.n = n;
+            m.shard = {i, count};
+            std::tie(m.rank_first, m.rank_last) = shard::shard_range(permutation_rank::factorial(static_cast<unsigned int>(n)), m.shard);
+            m.count = m.rank_last - m.rank_first;
+            r.push_back(m);
+        }
+        return r;
+    }
+}
+
+TEST(permutation_shard_test, parse_shard)
+{
+    const auto s = shard::parse_shard("2/5");
+    EXPECT_EQ(s.index, 2u);
+    EXPECT_EQ(s.count, 5u);
+    EXPECT_THROW(shard::parse_shard("5/5"), std::invalid_argument);
+    EXPECT_THROW(shard::parse_shard("0/0"), std::invalid_argument);
+    EXPECT_THROW(shard::parse_shard("1"), std::invalid_argument);
+    EXPECT_THROW(shard::parse_shard("1/2x"), std::invalid_argument);
+}
+
+TEST(permutation_shard_test, shard_range)
+{
+    rank_type covered = 0;
+    for (rank_type i = 0; i < 7; ++i)
+    {
+        const auto [lo, hi] = shard::shard_range(720, {i, 7});
+        EXPECT_EQ(lo, covered);
+        EXPECT_TRUE(hi - lo == 720 / 7 || hi - lo == 720 / 7 + 1);
+        covered = hi;
+    }
+    EXPECT_EQ(covered, 720u);
+}
+
+TEST(permutation_shard_test, manifest_round_trip)
+{
+    const perm_type elems{"a"sv, "b"sv};
+    auto m = make_shards(6, 4)[1];
+    m.elements_hash = shard::elements_hash(std::cbegin(elems), std::cend(elems));
+    m.digest.add(std::cbegin(elems), std::cend(elems));
+    m.output_hash = checksum::fnv1a("a b\nb a\n");
+    m.output = "out 1.txt";
+    std::stringstream ss;
+    shard::write_manifest(ss, m);
+    const auto r = shard::read_manifest(ss);
+    EXPECT_EQ(r.algorithm, m.algorithm);
+    EXPECT_EQ(r.order, m.order);
+    EXPECT_EQ(r.n, m.n);
+    EXPECT_EQ(r.elements_hash, m.elements_hash);
+    EXPECT_EQ(r.shard.index, 1u);
+    EXPECT_EQ(r.shard.count, 4u);
+    EXPECT_EQ(r.rank_first, m.rank_first);
+    EXPECT_EQ(r.rank_last, m.rank_last);
+    EXPECT_EQ(r.count, m.count);
+    EXPECT_EQ(r.digest, m.digest);
+    EXPECT_EQ(r.output_hash, m.output_hash);
+    EXPECT_EQ(r.output, m.output);
+
+    std::istringstream bad("n six\n");
+    EXPECT_THROW(shard::read_manifest(bad), std::runtime_error);
+}
+
+TEST(permutation_shard_test, verify)
+{
+    auto shards = make_shards(6, 5);
+    std::swap(shards[0], shards[3]);
+    shards[2].digest.sum = 5;
+    shards[4].digest.sum = 7;
+    const auto [total, sum] = shard::verify(shards);
+    EXPECT_EQ(total, 720u);
+    EXPECT_EQ(sum.sum, 12u);
+    EXPECT_EQ(shards[0].rank_first, 0u);
+
+    auto missing = make_shards(6, 5);
+    missing.erase(std::begin(missing) + 2);
+    EXPECT_THROW(shard::verify(missing), std::runtime_error);
+
+    auto twice = make_shards(6, 5);
+    twice.push_back(twice[1]);
+    EXPECT_THROW(shard::verify(twice), std::runtime_error);
+
+    auto short_count = make_shards(6, 5);
+    --short_count[4].count;
+    EXPECT_THROW(shard::verify(short_count), std::runtime_error);
+
+    auto mixed = make_shards(6, 2);
+    mixed[1].elements_hash = 1;
+    EXPECT_THROW(shard::verify(mixed), std::runtime_error);
+}
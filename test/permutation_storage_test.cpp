@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_storage.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"1"sv, "2"sv, "3"sv, "4"sv, "5"sv, "6"sv};
+}
+
+TEST(permutation_storage_test, huge_buffer)
+{
+    EXPECT_EQ(storage::huge_buffer().data(), nullptr);
+    for (const auto policy : {storage::page_policy::normal, storage::page_policy::transparent, storage::page_policy::hugetlb})
+    {
+        SCOPED_TRACE(storage::to_string(policy));
+        storage::huge_buffer b(storage::huge_page_size + 1, policy);
+        ASSERT_NE(b.data(), nullptr);
+        EXPECT_EQ(b.size(), 2 * storage::huge_page_size);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(b.data()) % storage::huge_page_size, 0u);
+        if (policy != storage::page_policy::hugetlb) EXPECT_EQ(b.policy(), policy);
+        else EXPECT_NE(b.policy(), storage::page_policy::normal);
+        std::memset(b.data(), 1, b.size());
+
+        auto moved = std::move(b);
+        EXPECT_EQ(b.data(), nullptr);
+        EXPECT_EQ(static_cast<const char *>(moved.data())[moved.size() - 1], 1);
+    }
+}
+
+TEST(permutation_storage_test, sizes_too_large)
+{
+    constexpr auto max = std::numeric_limits<std::size_t>::max();
+    EXPECT_THROW(storage::huge_buffer{max}, std::length_error);
+    EXPECT_THROW(storage::flat_perms(max / 2, 3), std::length_error);
+    EXPECT_THROW(storage::flat_perms(2, max / sizeof(elem_type)), std::length_error);
+    EXPECT_EQ(storage::flat_perms(0, max).capacity(), max);
+}
+
+TEST(permutation_storage_test, materialize)
+{
+    const auto expected = perm_all_container<std::vector<perm_type>>(permutation2::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    const auto flat = storage::materialize(permutation2::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems));
+    ASSERT_EQ(flat.size(), std::size(expected));
+    EXPECT_EQ(flat.n(), std::size(test_elems));
+    for (std::size_t i = 0; i < flat.size(); ++i)
+    {
+        ASSERT_EQ(perm_type(std::cbegin(flat[i]), std::cend(flat[i])), expected[i]) << i;
+    }
+
+    storage::flat_perms small(3, 1, storage::page_policy::normal);
+    small.push_back(std::cbegin(test_elems), std::next(std::cbegin(test_elems), 3));
+    EXPECT_THROW(small.push_back(std::cbegin(test_elems), std::next(std::cbegin(test_elems), 3)), std::length_error);
+    storage::flat_perms other(3, 1);
+    EXPECT_THROW(other.push_back(std::cbegin(test_elems), std::cend(test_elems)), std::invalid_argument);
+}
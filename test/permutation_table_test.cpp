@@ -0,0 +1,146 @@
+#include <any>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include "../permutation_table.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"c"sv, "a"sv, "e"sv, "b"sv, "d"sv, "f"sv};
+
+    class permutation_table_test : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            dir_ = std::filesystem::temp_directory_path() / ("permutation_table_test." + std::to_string(::getpid()));
+        }
+        void TearDown() override
+        {
+            std::filesystem::remove_all(dir_);
+        }
+
+        std::filesystem::path dir_;
+    };
+
+    std::vector<perm_type> collect(const table::mapped_table &t, const rank_type first, const rank_type last)
+    {
+        std::vector<perm_type> r;
+        t.perm_range(std::cbegin(test_elems), std::cend(test_elems), first, last,
+            [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) { r.emplace_back(f, l); }, {});
+        return r;
+    }
+}
+
+TEST_F(permutation_table_test, same_permutations_as_engines)
+{
+    for (const auto order : {registry::perm_order::lexicographic, registry::perm_order::insertion, registry::perm_order::plain_changes, registry::perm_order::heap})
+    {
+        SCOPED_TRACE(registry::to_string(order));
+        const auto t = table::load(static_cast<unsigned int>(std::size(test_elems)), order, dir_);
+        EXPECT_EQ(t.n(), std::size(test_elems));
+        EXPECT_EQ(t.order(), order);
+        ASSERT_EQ(t.size(), 720u);
+        registry::requirements req;
+        req.order = order;
+        const auto expected = perm_all_container<std::vector<perm_type>>(registry::select_engine(req).perm_all, std::cbegin(test_elems), std::cend(test_elems));
+        EXPECT_EQ(collect(t, 0, t.size()), expected);
+        EXPECT_EQ(collect(t, 100, 200), std::vector<perm_type>(std::next(std::cbegin(expected), 100), std::next(std::cbegin(expected), 200)));
+        EXPECT_THROW(collect(t, 0, 721), std::out_of_range);
+
+        // Lexicographic rows index the sorted elements, which must be distinct.
+        const perm_type repeated{"a"sv, "b"sv, "a"sv, "c"sv, "d"sv, "e"sv};
+        const auto run = [&] { t.perm_all(std::cbegin(repeated), std::cend(repeated), [](auto, auto, const std::any &) {}, {}); };
+        if (order == registry::perm_order::lexicographic) EXPECT_THROW(run(), std::invalid_argument);
+        else EXPECT_NO_THROW(run());
+    }
+}
+
+TEST_F(permutation_table_test, reuses_and_repairs_cache)
+{
+    const auto path = table::cache_path(dir_, 5, registry::perm_order::heap);
+    table::load(5, registry::perm_order::heap, dir_);
+    ASSERT_TRUE(std::filesystem::exists(path));
+    EXPECT_EQ(std::filesystem::file_size(path), table::header_size + 600);
+
+    // A cached table is mapped, not generated again.
+    const auto written = std::filesystem::last_write_time(path);
+    const auto t = table::load(5, registry::perm_order::heap, dir_);
+    EXPECT_EQ(std::filesystem::last_write_time(path), written);
+    const std::vector<std::uint8_t> second_row(std::cbegin(t[1]), std::cend(t[1]));
+    EXPECT_EQ(second_row, (std::vector<std::uint8_t>{1, 0, 2, 3, 4}));
+
+    // A corrupt one is detected and replaced.
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(table::header_size + 7);
+        f.put(9);
+    }
+    EXPECT_THROW(table::open_table(path), std::runtime_error);
+    EXPECT_NO_THROW(table::open_table(path, false));
+    // Loading maps it without reading it all; verifying replaces it.
+    EXPECT_NO_THROW(table::load(5, registry::perm_order::heap, dir_));
+    EXPECT_THROW(table::open_table(path), std::runtime_error);
+    const auto repaired = table::load(5, registry::perm_order::heap, dir_, true);
+    EXPECT_NO_THROW(table::open_table(path));
+
+    EXPECT_THROW(table::open_table(dir_ / "missing"), std::system_error);
+    EXPECT_THROW(table::load(table::max_table_n + 1, registry::perm_order::heap, dir_), std::domain_error);
+}
+
+TEST_F(permutation_table_test, shared_memory)
+{
+    const auto name = "/permutation_table_test." + std::to_string(::getpid());
+    table::unpublish(name);
+    EXPECT_THROW(table::attach(name), std::system_error);
+
+    // Attach while another thread publishes.
+    std::optional<table::mapped_table> published;
+    std::thread publisher([&] { published = table::publish(8, registry::perm_order::plain_changes, name); });
+    std::optional<table::mapped_table> attached;
+    while (!attached)
+    {
+        try
+        {
+            attached = table::attach(name);
+        }
+        catch (const std::system_error &)
+        {
+            std::this_thread::yield();
+        }
+    }
+    publisher.join();
+
+    const auto file = table::load(8, registry::perm_order::plain_changes, dir_);
+    ASSERT_EQ(attached->size(), file.size());
+    EXPECT_EQ(std::memcmp(attached->data(), file.data(), file.size() * 8), 0);
+    EXPECT_EQ(std::memcmp(published->data(), file.data(), file.size() * 8), 0);
+    // Publishing again maps the existing table.
+    EXPECT_EQ(table::publish(8, registry::perm_order::plain_changes, name).data()[8], file.data()[8]);
+    EXPECT_THROW(table::publish(7, registry::perm_order::plain_changes, name), std::runtime_error);
+
+    table::unpublish(name);
+    EXPECT_THROW(table::attach(name), std::system_error);
+    // The mappings outlive the object.
+    EXPECT_EQ(std::memcmp(attached->data(), file.data(), file.size() * 8), 0);
+
+    // An object whose publisher never finished.
+    const auto fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::ftruncate(fd, 4096), 0);
+    ::close(fd);
+    EXPECT_THROW(table::attach(name, std::chrono::milliseconds(20)), std::runtime_error);
+    table::unpublish(name);
+}
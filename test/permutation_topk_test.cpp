@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_parallel.h"
+#include "../permutation_topk.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"3"sv, "1"sv, "4"sv, "1x"sv, "5"sv, "9"sv, "2"sv};
+
+    // Many permutations share a score, so ties are exercised.
+    long score(const perm_iterator_type first, const perm_iterator_type last)
+    {
+        long r = 0;
+        for (auto it = first; it != last; ++it) r += (it - first) * (*it)[0];
+        return r % 97;
+    }
+
+    // The best k by materializing and sorting everything.
+    std::vector<topk::entry<long>> expected_best(const std::size_t k)
+    {
+        std::vector<topk::entry<long>> all;
+        for (auto &p : perm_all_container<std::vector<perm_type>>(permutation_std::perm_all<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems)))
+        {
+            all.push_back({score(std::cbegin(p), std::cend(p)), std::move(p)});
+        }
+        std::sort(std::begin(all), std::end(all), [](const auto &a, const auto &b) { return std::tie(a.score, a.perm) < std::tie(b.score, b.perm); });
+        all.resize(std::min(k, std::size(all)));
+        return all;
+    }
+
+    void expect_same(const std::vector<topk::entry<long>> &actual, const std::vector<topk::entry<long>> &expected)
+    {
+        ASSERT_EQ(std::size(actual), std::size(expected));
+        for (std::size_t i = 0; i < std::size(actual); ++i)
+        {
+            EXPECT_EQ(actual[i].score, expected[i].score);
+            EXPECT_EQ(actual[i].perm, expected[i].perm);
+        }
+    }
+}
+
+TEST(permutation_topk_test, sequential)
+{
+    for (const std::size_t k : {0u, 1u, 10u, 6000u})
+    {
+        SCOPED_TRACE(k);
+        topk::collector<long> c(k, score);
+        permutation4::perm_all<perm_iterator_type>(std::cbegin(test_elems), std::cend(test_elems), c.output_each_perm, c.worker_data()[0]);
+        expect_same(c.results(), expected_best(k));
+    }
+}
+
+TEST(permutation_topk_test, parallel)
+{
+    topk::collector<long> c(25, score, 4);
+    permutation_parallel::perm_all(permutation_std::perm_range<perm_iterator_type>, std::cbegin(test_elems), std::cend(test_elems), c.output_each_perm, c.worker_data());
+    const auto expected = expected_best(25);
+    expect_same(c.results(), expected);
+    // A worker's k-th best is no better than the overall k-th best.
+    EXPECT_GE(c.threshold(), expected.back().score);
+}
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "../permutation_trie.h"
+
+using namespace permutation_algorithms;
+using namespace std::literals::string_view_literals;
+
+namespace
+{
+    const perm_type test_elems{"a"sv, "b"sv, "c"sv, "d"sv, "e"sv, "f"sv, "g"sv};
+
+    // Permutations without a descent at an even position, in lexicographic order.
+    std::vector<perm_type> filtered()
+    {
+        std::vector<perm_type> r;
+        permutation_std::perm_all(std::cbegin(test_elems), std::cend(test_elems), [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) {
+            for (std::size_t i = 0; i + 1 < std::size(test_elems); i += 2)
+            {
+                if (f[i + 1] < f[i]) return;
+            }
+            r.emplace_back(f, l);
+        }, {});
+        return r;
+    }
+
+    trie::trie build(const perm_type &elems, const std::vector<perm_type> &keys)
+    {
+        trie::builder b(std::cbegin(elems), std::cend(elems));
+        for (const auto &k : keys) b.add(std::cbegin(k), std::cend(k));
+        return std::move(b).finish();
+    }
+}
+
+TEST(permutation_trie_test, membership_rank_select)
+{
+    const auto keys = filtered();
+    ASSERT_EQ(std::size(keys), 5040u / 8);
+    const auto t = build(test_elems, keys);
+    EXPECT_EQ(t.size(), std::size(keys));
+    EXPECT_LT(t.bytes(), std::size(keys) * std::size(test_elems));
+
+    rank_type next = 0;
+    permutation_std::perm_all(std::cbegin(test_elems), std::cend(test_elems), [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) {
+        const auto r = t.rank(f, l);
+        const bool expected = next < std::size(keys) && perm_type(f, l) == keys[next];
+        ASSERT_EQ(r.has_value(), expected);
+        ASSERT_EQ(t.contains(f, l), expected);
+        if (expected)
+        {
+            ASSERT_EQ(*r, next);
+            ASSERT_EQ(t.select(next), keys[next]);
+            ++next;
+        }
+    }, {});
+    EXPECT_THROW(t.select(t.size()), std::out_of_range);
+    const perm_type stranger{"a"sv, "b"sv, "c"sv, "d"sv, "e"sv, "f"sv, "z"sv};
+    EXPECT_FALSE(t.contains(std::cbegin(stranger), std::cend(stranger)));
+    EXPECT_FALSE(t.contains(std::cbegin(test_elems), std::next(std::cbegin(test_elems), 3)));
+}
+
+TEST(permutation_trie_test, prefix_iteration)
+{
+    const auto keys = filtered();
+    const auto t = build(test_elems, keys);
+    for (const auto &prefix : std::vector<perm_type>{{}, {"a"sv}, {"c"sv, "d"sv}, {"d"sv, "c"sv}, {"a"sv, "b"sv, "c"sv, "d"sv, "e"sv, "f"sv}, keys[17]})
+    {
+        SCOPED_TRACE(testing::PrintToString(prefix));
+        std::vector<perm_type> expected;
+        std::copy_if(std::cbegin(keys), std::cend(keys), std::back_inserter(expected),
+            [&](const perm_type &k) { return std::equal(std::cbegin(prefix), std::cend(prefix), std::cbegin(k)); });
+        std::vector<perm_type> actual;
+        t.for_each_prefix(std::cbegin(prefix), std::cend(prefix), [&](const perm_iterator_type f, const perm_iterator_type l) { actual.emplace_back(f, l); });
+        EXPECT_EQ(actual, expected);
+    }
+    std::vector<perm_type> all;
+    t.for_each([&](const perm_iterator_type f, const perm_iterator_type l) { all.emplace_back(f, l); });
+    EXPECT_EQ(all, keys);
+}
+
+TEST(permutation_trie_test, building)
+{
+    const auto keys = filtered();
+    trie::builder b(std::cbegin(test_elems), std::cend(test_elems));
+    b.add(std::cbegin(keys[1]), std::cend(keys[1]));
+    EXPECT_THROW(b.add(std::cbegin(keys[1]), std::cend(keys[1])), std::invalid_argument);
+    EXPECT_THROW(b.add(std::cbegin(keys[0]), std::cend(keys[0])), std::invalid_argument);
+    EXPECT_THROW(b.add(std::cbegin(test_elems), std::next(std::cbegin(test_elems), 3)), std::invalid_argument);
+
+    // The full set has one node per prefix of length 1 ... n-1.
+    std::vector<perm_type> all;
+    permutation_std::perm_all(std::cbegin(test_elems), std::cend(test_elems), [&](const perm_iterator_type f, const perm_iterator_type l, const std::any &) { all.emplace_back(f, l); }, {});
+    const auto full = build(test_elems, all);
+    EXPECT_EQ(full.nodes(), 7u + 42 + 210 + 840 + 2520 + 5040);
+    EXPECT_EQ(full.rank(std::cbegin(all[4000]), std::cend(all[4000])), 4000u);
+
+    for (const std::size_t n : {0, 1, 2})
+    {
+        const perm_type elems(std::cbegin(test_elems), std::next(std::cbegin(test_elems), n));
+        const auto empty = build(elems, {});
+        EXPECT_EQ(empty.size(), 0u);
+        EXPECT_FALSE(empty.contains(std::cbegin(elems), std::cend(elems)));
+        const auto one = build(elems, {elems});
+        EXPECT_EQ(one.size(), 1u);
+        EXPECT_EQ(one.rank(std::cbegin(elems), std::cend(elems)), 0u);
+        EXPECT_EQ(one.select(0), elems);
+    }
+}